@@ -24,17 +24,17 @@ int get_data();
 // Post: The user has been prompted to enter an integer. The number
 // has been read, echoed to the screen, and returned by the function.
 
-p_queue::size_type get_priority();
+p_queue<>::priority_type get_priority();
 // Pre:  (none)
 // Post: The user has been prompted to enter an integer. The number
 // has been read, echoed to the screen, and returned by the function.
 
 int main()
 {
-   p_queue test; // PQ to perform test on
+   p_queue<> test; // PQ to perform test on
    char choice;  // command character entered by user
    int data;     // PQ item data entered by user
-   p_queue::size_type priority; // PQ item priority entered by user
+   p_queue<>::priority_type priority; // PQ item priority entered by user
 
    cout << "I have created an empty p_queue (PQ)." << endl;
    cout << "The data of an item of this PQ will be an integer,\n";
@@ -57,9 +57,8 @@ int main()
       case 'D':
          if ( !test.empty() )
          {
-            cout << "Item " << test.front() << " has been dequeued."
+            cout << "Item " << test.pop() << " has been dequeued."
                  << endl;
-            test.pop();
          }
          else
             cout << "PQ is empty, nothing to dequeue." << endl;
@@ -136,9 +135,9 @@ int get_data()
    return number;
 }
 
-p_queue::size_type get_priority()
+p_queue<>::priority_type get_priority()
 {
-   p_queue::size_type priority;
+   p_queue<>::priority_type priority;
    char oneChar;
    bool done = true;
 
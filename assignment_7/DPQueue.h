@@ -1,30 +1,59 @@
 // FILE: DPQueue.h
-// CLASS PROVIDED: p_queue (priority queue ADT)
+// TEMPLATE CLASS PROVIDED: p_queue<T, Priority, Compare, D> (priority
+//                 queue ADT, kept in a d-ary heap)
 //
-// TYPEDEFS and MEMBER CONSTANTS for the p_queue class:
-//   typedef _____ value_type
-//     p_queue::value_type is the data type of the items in
-//     the p_queue. It may be any of the C++ built-in types
-//     (int, char, etc.), or a class with a default constructor, a
-//     copy constructor, an assignment operator, and a less-than
-//     operator forming a strict weak ordering.
+// TEMPLATE PARAMETERS, TYPEDEFS and MEMBER CONSTANTS for the p_queue
+// class:
+//   p_queue<T, Priority, Compare, D> class
+//   The template parameter, T (int if not given), is the data type of
+//   the items in the p_queue, also defined as p_queue::value_type.
+//   It may be any of the C++ built-in types (int, char, etc.), or a
+//   class with a move constructor and a move assignment operator
+//   (a copy constructor and assignment operator will do); it needs
+//   no default constructor, and it needs to be copyable only if the
+//   p_queue is copied or items are pushed by copy.
+//
+//   The template parameter, Priority (size_t if not given), is the
+//   data type of the priority associated with each item in the
+//   p_queue, also defined as p_queue::priority_type. It may be any
+//   type Compare can compare, with a copy constructor and an
+//   assignment operator.
+//
+//   The template parameter, Compare (std::less<Priority> if not
+//   given), is a function object type, also defined as
+//   p_queue::priority_compare: compare(a, b), for a Compare object
+//   compare, returns true if priority a is lower than priority b, and
+//   must form a strict weak ordering. (The item of highest priority
+//   comes out first, as from a std::priority_queue;
+//   std::greater<Priority> makes the lowest come out first.)
+//
+//   The template parameter, D (2 if not given), is the # of children
+//   each node of the heap has, also defined as p_queue::ARITY. It must
+//   be at least 2. A wider heap is shallower: push() climbs fewer
+//   levels, and so does pop(), though it compares D children (which
+//   lie next to one another) on each. With D = 4 and items of 16
+//   bytes (an int and a size_t, say) the children of a node fill one
+//   64-byte cache line (the array is laid out so they never straddle
+//   two), so pop() takes about one cache miss per level, on half the
+//   levels of a binary heap. (See PQBench.cpp for a comparison of 2,
+//   4 and 8.)
 //
 //   typedef _____ size_type
 //     p_queue::size_type is the data type considered best-suited
 //     for any variable meant for counting and sizing (as well as
 //     array-indexing) purposes; e.g.: it is the data type for a
 //     variable representing how many items are in the p_queue.
-//     It is also the data type of the priority associated with
-//     each item in the p_queue
 //
 //   static const size_type DEFAULT_CAPACITY = _____
 //    p_queue::DEFAULT_CAPACITY is the default initial capacity of a
 //    p_queue that is created by the default constructor.
 //
 // CONSTRUCTOR for the p_queue class:
-//   p_queue(size_type initial_capacity = DEFAULT_CAPACITY)
+//   p_queue(size_type initial_capacity = DEFAULT_CAPACITY,
+//           const priority_compare& comp = priority_compare())
 //     Pre:  initial_capacity > 0
-//     Post: The p_queue has been initialized to an empty p_queue.
+//     Post: The p_queue has been initialized to an empty p_queue,
+//       whose priorities comp compares.
 //       The push function will work efficiently (without allocating
 //       new memory) until this capacity is reached.
 //     Note: If Pre is not met, initial_capacity will be adjusted to
@@ -38,15 +67,28 @@
 //       0 in amount).
 //
 // MODIFICATION MEMBER FUNCTIONS for the p_queue class:
-//   void push(const value_type& entry, size_type priority)
+//   void push(const value_type& entry, const priority_type& priority)
+//     Pre:  (none)
+//     Post: A new copy of entry with the specified priority has been
+//           added to the p_queue.
+//
+//   void push(value_type&& entry, const priority_type& priority)
+//     Pre:  (none)
+//     Post: entry, with the specified priority, has been moved into
+//           the p_queue (it is left as a moved-from object).
+//
+//   template <class... Args>
+//   void emplace(const priority_type& priority, Args&&... args)
 //     Pre:  (none)
-//     Post: A new copy of item with the specified data and priority
-//           has been added to the p_queue.
+//     Post: A new item with the specified priority, constructed in
+//           place from args (as value_type(args...)), has been added
+//           to the p_queue.
 //
-//   void pop()
+//   value_type pop()
 //     Pre:  size() > 0.
 //     Post: The highest priority item has been removed from the
-//           p_queue. (If several items have the equal priority,
+//           p_queue, and the return value is its data, moved out of
+//           the p_queue. (If several items have the equal priority,
 //           then the implementation may decide which one to remove.)
 //
 // CONSTANT MEMBER FUNCTIONS for the p_queue class:
@@ -55,12 +97,19 @@
 //     Post: The return value is the total number of items in the
 //           p_queue.
 //
-//   value_type front() const
+//   const value_type& front() const
 //     Pre:  size() > 0.
 //     Post: The return value is the data of the highest priority
 //           item in the p_queue, but the p_queue is unchanged.
 //           (If several items have equal priority, then the
-//           implementation may decide which one to return.)
+//           implementation may decide which one to return.) It
+//           refers to the item in the p_queue, so it is valid only
+//           until the p_queue is next changed.
+//
+//   const priority_type& front_priority() const
+//     Pre:  size() > 0.
+//     Post: The return value is the priority of the item front()
+//           returns, with the same lifetime.
 //
 //   bool empty() const
 //     Pre:  (none)
@@ -69,34 +118,51 @@
 //
 // VALUE SEMANTICS for the p_queue class:
 //   Assignments and the copy constructor may be used with p_queue
-//   objects.
+//   objects whose value_type can be copied. A p_queue can always be
+//   moved (by the move constructor or move assignment), which takes
+//   its items over without moving any; the p_queue moved from is
+//   left empty.
 
 #ifndef D_P_QUEUE_H
 #define D_P_QUEUE_H
 
-#include <cstdlib> // provides size_t
+#include <cstdlib>    // provides size_t
+#include <functional> // provides less
+#include <type_traits> // provides is_scalar, true_type, false_type
 
 namespace CS3358_FA2018_A7
 {
+   template <class T = int, class Priority = size_t,
+             class Compare = std::less<Priority>, size_t D = 2>
    class p_queue
    {
    public:
       // TYPEDEFS and MEMBER CONSTANTS
-      typedef int value_type;
+      typedef T value_type;
+      typedef Priority priority_type;
+      typedef Compare priority_compare;
       typedef size_t size_type;
       static const size_type DEFAULT_CAPACITY = 1;
+      static const size_type ARITY = D;
       // CONSTRUCTORS AND DESTRUCTOR
-      p_queue(size_type initial_capacity = DEFAULT_CAPACITY);
+      p_queue(size_type initial_capacity = DEFAULT_CAPACITY,
+              const priority_compare& comp = priority_compare());
       p_queue(const p_queue& src);
+      p_queue(p_queue&& src);
       ~p_queue();
       // MODIFICATION MEMBER FUNCTIONS
       p_queue& operator=(const p_queue& rhs);
-      void push(const value_type& entry, size_type priority);
-      void pop();
+      p_queue& operator=(p_queue&& rhs);
+      void push(const value_type& entry, const priority_type& priority);
+      void push(value_type&& entry, const priority_type& priority);
+      template <class... Args>
+      void emplace(const priority_type& priority, Args&&... args);
+      value_type pop();
       // CONSTANT MEMBER FUNCTIONS
       size_type size() const;
       bool empty() const;
-      value_type front() const;
+      const value_type& front() const;
+      const priority_type& front_priority() const;
       // EXTRA CONSTANT MEMBER FUNCTION FOR DEBUG PRINTING
       void print_tree(const char message[] = "", size_type i = 0) const;
       void print_array(const char message[] = "") const;
@@ -106,22 +172,36 @@ namespace CS3358_FA2018_A7
       struct ItemType
       {
          value_type data;
-         size_type priority;
+         priority_type priority;
+
+         template <class... Args>
+         ItemType(const priority_type& item_priority, Args&&... args);
       };
+      static_assert(D >= 2, "a heap node needs at least 2 children");
+      // bytes in a cache line, the unit the children of a node are
+      // aligned to
+      static const size_type LINE_BYTES = 64;
+      static_assert(alignof(ItemType) <= LINE_BYTES,
+                    "items must fit the cache line alignment");
       // PRIVATE MEMBER VARIABLES
-      ItemType *heap;
+      void *storage;       // the raw memory allocated
+      ItemType *heap;      // where the heap starts in storage
       size_type capacity;
       size_type used;
+      priority_compare compare;
       // HELPER FUNCTIONS
+      void allocate(size_type new_capacity);
+      void release();
       void resize(size_type new_capacity);
+      void sift_up(size_type i);
       bool is_leaf(size_type i) const;
       size_type parent_index(size_type i) const;
-      size_type parent_priority(size_type i) const;
       size_type big_child_index(size_type i) const;
-      size_type big_child_priority(size_type i) const;
-      void swap_with_parent(size_type i);
+      size_type big_child_index(size_type i, std::true_type) const;
+      size_type big_child_index(size_type i, std::false_type) const;
    };
 }
 
-#endif
+#include "DPQueue.template"
 
+#endif
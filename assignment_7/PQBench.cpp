@@ -0,0 +1,114 @@
+// FILE: PQBench.cpp
+// Compares p_queue heaps of arity 2, 4 and 8 (see DPQueue.h) holding
+// 1K, 10K, ... up to 100M items (or up to the # given on the command
+// line), with random priorities, reporting for each:
+//   push ns     time per push, filling the p_queue from empty
+//   hold ns     time per pop followed by a push (of an item of random
+//               priority) on the full p_queue, as in an event queue
+//   pop ns      time per pop, emptying the p_queue
+//   height      # of levels of the full heap
+// smaller heaps are filled and emptied several times, so each row
+// times at least a few million operations; run as
+//    pqbench [most items]
+#include "DPQueue.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+using namespace std;
+using namespace CS3358_FA2018_A7;
+
+// fewest pushes (and pops) each row times
+const size_t MIN_OPS = 4000000;
+
+double Seconds(clock_t ticks);
+size_t NextRandom(size_t& state);
+size_t Height(size_t n, size_t arity);
+template <size_t D>
+void BenchArity(size_t n, size_t& checksum);
+
+int main(int argc, char* argv[])
+{
+   size_t most = argc > 1 ? strtoull(argv[1], 0, 10) : 100000000;
+   size_t checksum = 0;
+
+   cout << setw(10) << "items" << setw(7) << "arity" << setw(9) << "push ns"
+        << setw(9) << "hold ns" << setw(9) << "pop ns" << setw(8) << "height"
+        << endl;
+   for (size_t n = 1000; n <= most; n *= 10)
+   {
+      BenchArity<2>(n, checksum);
+      BenchArity<4>(n, checksum);
+      BenchArity<8>(n, checksum);
+   }
+   // (printed so the pops cannot be optimized away)
+   cout << "checksum " << checksum << endl;
+   return EXIT_SUCCESS;
+}
+
+double Seconds(clock_t ticks)
+{ return double(ticks) / CLOCKS_PER_SEC; }
+
+// returns the next of a sequence of pseudo-random numbers (splitmix64)
+size_t NextRandom(size_t& state)
+{
+   size_t z = (state += 0x9e3779b97f4a7c15ULL);
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+}
+
+// returns the # of levels of a heap of n items whose nodes have arity
+// children
+size_t Height(size_t n, size_t arity)
+{
+   size_t levels = 0;
+   for (size_t width = 1; n > 0; width *= arity)
+   {
+      ++levels;
+      n = n > width ? n - width : 0;
+   }
+   return levels;
+}
+
+template <size_t D>
+void BenchArity(size_t n, size_t& checksum)
+{
+   size_t rounds = n < MIN_OPS ? MIN_OPS / n : 1;
+   size_t state = n;
+   double pushSecs = 0, holdSecs = 0, popSecs = 0;
+   p_queue<int, size_t, less<size_t>, D> pq(n);
+
+   for (size_t r = 0; r < rounds; ++r)
+   {
+      clock_t beg = clock();
+      for (size_t i = 0; i < n; ++i)
+         pq.push(int(i), NextRandom(state) >> 32);
+      clock_t end = clock();
+      pushSecs += Seconds(end - beg);
+
+      // (the pushes keep to the capacity: each follows a pop)
+      beg = clock();
+      for (size_t i = 0; i < n; ++i)
+      {
+         checksum += pq.pop();
+         pq.push(int(i), NextRandom(state) >> 32);
+      }
+      end = clock();
+      holdSecs += Seconds(end - beg);
+
+      beg = clock();
+      while ( ! pq.empty() )
+      {
+         checksum += pq.pop();
+      }
+      end = clock();
+      popSecs += Seconds(end - beg);
+   }
+
+   double ops = double(rounds) * n;
+   cout << setw(10) << n << setw(7) << D << fixed << setprecision(1)
+        << setw(9) << pushSecs * 1e9 / ops << setw(9) << holdSecs * 1e9 / ops
+        << setw(9) << popSecs * 1e9 / ops << setw(8) << Height(n, D) << endl;
+}
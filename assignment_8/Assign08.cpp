@@ -1,47 +1,74 @@
 #include "HashTable.h"
+#include "SpellSuggester.h"
+#include "Dawg.h"
+#include "TextKernels.h"
 #include <iostream>
-#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <chrono>
+#include <sys/stat.h>
 using namespace std;
 
-void MakeAllLowerCase(char* word);
+int Usage(const string& problem);
+bool IsUpToDate(const char* target, const char* source);
+void LoadDictionary(HashTable& hTab, bool smallDict);
+bool LoadGraph(Dawg& graph, const HashTable& hTab, bool smallDict);
+int CheckDocument(HashTable& hTab, const char* textName);
 
-int main()
+// most near matches suggested for a misspelled word
+const size_t MAX_SUGGESTIONS = 10;
+
+// run with no arguments, words are spell checked one at a time, as
+// they are entered; run as
+//    a8 [-s] textfile
+// every word of textfile (of standard input if textfile is -) is
+// checked against the big (with -s, the small) dictionary, and the
+// misspelled ones are listed, each with its byte offset in the text
+int main(int argc, char* argv[])
 {
    HashTable hTab;
+   if (argc > 1)
+   {
+      // the only option is -s, given at most once, besides which
+      // there must be exactly one textfile ("-" on its own being
+      // standard input, not an option)
+      bool smallDict = false;
+      const char* textName = 0;
+      for (int a = 1; a < argc; ++a)
+      {
+         if (strcmp(argv[a], "-s") == 0 && smallDict)
+            return Usage("option -s given twice");
+         else if (strcmp(argv[a], "-s") == 0)
+            smallDict = true;
+         else if (argv[a][0] == '-' && argv[a][1] != '\0')
+            return Usage(string("unknown option ") + argv[a]);
+         else if (textName == 0)
+            textName = argv[a];
+         else
+            return Usage(string("unexpected argument ") + argv[a]);
+      }
+      if (textName == 0)
+         return Usage("missing textfile");
+      LoadDictionary(hTab, smallDict);
+      return CheckDocument(hTab, textName);
+   }
    cout << "capacity initially: " << hTab.cap() << endl;
    cout << "used initially:     " << hTab.size() << endl;
    char dictOption;
    cout << "select dictionary (s = small, others = big): ";
    cin >> dictOption;
    cin.ignore(9999, '\n');
-   ifstream fin;
-   if (dictOption == 's' || dictOption == 'S')
-      fin.open("dict0.txt", ios::in);
-   else
-      fin.open("dict1.txt", ios::in);
-   if ( fin.fail() )
-   {
-      cerr << "Failed to open dictionary file "
-           << ( (dictOption == 's') ? "dict0.txt" : "dict1.txt" ) << "..."
-           << "\nMake dictionary files accessible and try again ..." << endl;
-      exit(EXIT_FAILURE);
-   }
+   bool smallDict = (dictOption == 's' || dictOption == 'S');
    clock_t begLoad;   // for timing hashtable load
    clock_t endLoad;   // for timing hashtable load
    char oneWord[101]; // holder for word (up to 100 chars)
    cout << "loading dictionary . . ." << endl;
    begLoad = clock();
-   fin >> ws;
-   while ( ! fin.eof() )
-   {
-      fin >> oneWord;
-      if ( ! hTab.exists(oneWord) ) hTab.insert(oneWord);
-      fin >> ws;
-   }
-   fin.close();
+   LoadDictionary(hTab, smallDict);
    endLoad = clock() - begLoad;
    cout << "dictionary loaded in "
         << (double)endLoad / ((double)CLOCKS_PER_SEC)
@@ -51,6 +78,14 @@ int main()
    cout << "load-factor:        " << hTab.load_factor() << endl;
    hTab.grading_helper_print(cout);
    hTab.scat_plot(cout);
+   // near matches one edit away are found by generating candidates
+   // and looking them up, those two edits away (which are far more)
+   // by walking the automaton of the words, or failing that by
+   // generating candidates as well
+   Dawg graph;
+   bool walkGraph = LoadGraph(graph, hTab, smallDict);
+   SpellSuggester generator(hTab), walker(hTab, graph);
+   const SpellSuggester& farSuggester = walkGraph ? walker : generator;
 
    char response;
    do
@@ -59,37 +94,29 @@ int main()
       cin >> oneWord;
       cin.ignore(9999, '\n'); // clear the cin buffer
       cout << endl;
-      MakeAllLowerCase(oneWord);
+      lower_ascii(oneWord, oneWord, strlen(oneWord));
       if ( hTab.search(oneWord) )
          cout << oneWord << " matches a word in dictionary ~ o ~" << endl;
       else
       {
-         char altWord[101];
-         bool suggLabPrinted = false;
-         for(HashTable::size_type x = 0; x < strlen(oneWord); ++x)
+         // the words one edit away (substitution, insertion, deletion
+         // or transposition) are suggested, or failing any, those two
+         // edits away, the most frequent first (if the dictionary has
+         // counts, otherwise alphabetically)
+         vector<string> suggestions;
+         generator.suggest_top(oneWord, suggestions, MAX_SUGGESTIONS, 1);
+         if( suggestions.empty() )
+            farSuggester.suggest_top(oneWord, suggestions, MAX_SUGGESTIONS, 2);
+         cout << oneWord << " not found in dictionary . . .\n";
+         if( ! suggestions.empty() )
          {
-            strcpy(altWord, oneWord);
-            for(char c = 'a'; c <= 'z'; ++c)
-            {
-               altWord[x] = c;
-               if( hTab.search(altWord) )
-               {
-                  if( ! suggLabPrinted)
-                  {
-                     cout << oneWord << " not found in dictionary . . .\n"
-                          << "   near match(es): ";
-                     suggLabPrinted = true;
-                  }
-                  cout << altWord << "  ";
-               }
-               strcpy(altWord, oneWord);
-            }
-         }
-         if(suggLabPrinted)
+            cout << "   near match(es): ";
+            for(vector<string>::size_type k = 0; k < suggestions.size(); ++k)
+               cout << suggestions[k] << "  ";
             cout << endl;
+         }
          else
-            cout << oneWord << " not found in dictionary . . .\n"
-                 << "   no near match(es) to suggest :-( \n";
+            cout << "   no near match(es) to suggest :-( \n";
       }
       cout << "\nMore word to spell check? (y/n): ";
       cin >> response;
@@ -102,12 +129,145 @@ int main()
    return EXIT_SUCCESS;
 }
 
-void MakeAllLowerCase(char* word)
+// loads the small (dict0.txt) or big (dict1.txt) dictionary into
+// hTab: a hash-table image saved by an earlier run is used as is (if
+// it is newer than the dictionary), otherwise the dictionary is
+// loaded and an image of it saved for the next run
+void LoadDictionary(HashTable& hTab, bool smallDict)
 {
-   HashTable::size_type i = 0;
-   while (word[i] != '\0')
+   const char* dictName  = smallDict ? "dict0.txt" : "dict1.txt";
+   const char* imageName = smallDict ? "dict0.img" : "dict1.img";
+   bool fromImage = IsUpToDate(imageName, dictName) &&
+                    hTab.open_image(imageName);
+   if ( ! fromImage && ! hTab.load_parallel(dictName) )
    {
-      word[i] = word[i] | 32;
-      ++i;
+      cerr << "Failed to open dictionary file " << dictName << "..."
+           << "\nMake dictionary files accessible and try again ..." << endl;
+      exit(EXIT_FAILURE);
    }
+   if ( ! fromImage )
+      hTab.save_image(imageName);
+}
+
+// loads into graph the automaton (see Dawg.h) of the words of hTab,
+// the small (dict0.txt) or big (dict1.txt) dictionary: one saved by
+// an earlier run is used as is (if it is newer than the
+// dictionary), otherwise it is built and saved for the next run;
+// returns false if it cannot be built
+bool LoadGraph(Dawg& graph, const HashTable& hTab, bool smallDict)
+{
+   const char* dictName  = smallDict ? "dict0.txt" : "dict1.txt";
+   const char* graphName = smallDict ? "dict0.dawg" : "dict1.dawg";
+   if ( IsUpToDate(graphName, dictName) && graph.open(graphName) &&
+        graph.has_counts() == hTab.has_counts() )
+      return true;
+   if ( ! graph.build(hTab) )
+      return false;
+   graph.save(graphName);
+   return true;
+}
+
+// every word (run of letters, lowercased) of the text file textName
+// (of standard input if textName is "-") is checked against hTab; the
+// misspelled ones are written to standard output, one per line, after
+// their byte offset in the text, and a summary (with the throughput)
+// to standard error
+// the text is read a chunk at a time, lowercased and split into words
+// in bulk (see TextKernels.h), and the words of a chunk are looked up
+// as one batch; a word cut off by the end of a chunk is carried over
+// to the next
+int CheckDocument(HashTable& hTab, const char* textName)
+{
+   const size_t CHUNK = 1 << 20;
+   FILE* in = strcmp(textName, "-") == 0 ? stdin : fopen(textName, "rb");
+   if (in == 0)
+   {
+      cerr << "Failed to open text file " << textName << endl;
+      return EXIT_FAILURE;
+   }
+   ios::sync_with_stdio(false);
+   chrono::steady_clock::time_point beg = chrono::steady_clock::now();
+   vector<char> raw(CHUNK), text;
+   vector<WordSpan> words;
+   vector<const char*> wordPtrs;
+   bool* wordFound = 0;
+   size_t carry = 0;      // # of bytes carried over to the next chunk
+   size_t chunkBase = 0;  // offset in the text of the chunk
+   size_t nWords = 0, nMisspelled = 0;
+   bool last = false;
+   while ( ! last )
+   {
+      if (raw.size() < carry + CHUNK)
+         raw.resize(carry + CHUNK);
+      size_t got = fread(&raw[carry], 1, CHUNK, in);
+      last = (got < CHUNK);
+      size_t n = carry + got;
+      text.resize(n + 1);
+      lower_ascii(&raw[0], &text[0], n);
+      words.clear();
+      find_words(&text[0], n, words);
+      size_t done = n;
+      if ( ! last && ! words.empty() &&
+           words.back().start + words.back().length == n )
+      {
+         done = words.back().start;
+         words.pop_back();
+      }
+
+      // each word is null-terminated in place (over the byte after it,
+      // which is not a letter)
+      wordPtrs.resize(words.size());
+      for (size_t w = 0; w < words.size(); ++w)
+      {
+         text[words[w].start + words[w].length] = '\0';
+         wordPtrs[w] = &text[words[w].start];
+      }
+      delete [] wordFound;
+      wordFound = new bool[words.size() + 1];
+      hTab.search_batch(wordPtrs.empty() ? 0 : &wordPtrs[0], words.size(),
+                        wordFound);
+      for (size_t w = 0; w < words.size(); ++w)
+         if ( ! wordFound[w] )
+         {
+            cout << chunkBase + words[w].start << ' ' << wordPtrs[w] << '\n';
+            ++nMisspelled;
+         }
+      nWords += words.size();
+
+      carry = n - done;
+      memmove(&raw[0], &raw[done], carry);
+      chunkBase += done;
+   }
+   delete [] wordFound;
+   if (in != stdin)
+      fclose(in);
+   cout.flush();
+   double secs = chrono::duration<double>(chrono::steady_clock::now()
+                                          - beg).count();
+   cerr << nWords << " words (" << chunkBase << " bytes) checked in "
+        << secs << " seconds, " << nMisspelled << " misspelled, "
+        << (secs > 0 ? chunkBase / secs / 1e6 : 0) << " MB/s" << endl;
+   return EXIT_SUCCESS;
+}
+
+// writes problem (what is wrong with the command line) and how a8 is
+// run to standard error; returns EXIT_FAILURE
+int Usage(const string& problem)
+{
+   cerr << "a8: " << problem << "\nusage: a8 [-s] textfile" << endl;
+   return EXIT_FAILURE;
+}
+
+// returns true if file target exists and was last modified after
+// file source (to the nanosecond, so that a source changed within the
+// same second is caught; one changed at the very same time counts as
+// newer), otherwise returns false
+bool IsUpToDate(const char* target, const char* source)
+{
+   struct stat targetInfo, sourceInfo;
+   if ( stat(target, &targetInfo) != 0 || stat(source, &sourceInfo) != 0 )
+      return false;
+   if ( targetInfo.st_mtim.tv_sec != sourceInfo.st_mtim.tv_sec )
+      return targetInfo.st_mtim.tv_sec > sourceInfo.st_mtim.tv_sec;
+   return targetInfo.st_mtim.tv_nsec > sourceInfo.st_mtim.tv_nsec;
 }
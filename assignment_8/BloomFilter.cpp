@@ -0,0 +1,110 @@
+#include "BloomFilter.h"
+#include <cmath>    // for use of exp, log, lgamma, pow, sqrt
+#include <cstring>  // for use of memset
+#include <utility>  // for use of swap
+using namespace std;
+
+// constructs a filter with no bits, which every key passes (reset
+// gives it some)
+BloomFilter::BloomFilter()
+   : storage(0), bits(0), n_blocks(0), n_probes(0), n_keys(0) { }
+
+// returns the bits to the heap
+BloomFilter::~BloomFilter()
+{ delete [] storage; }
+
+// the filter is emptied and sized for keys keys at bits_per_key bits
+// each (rounded up to whole blocks), setting the # of bits per key
+// that keeps the false-positive rate lowest, bits_per_key * ln 2
+void BloomFilter::reset(size_type keys, unsigned bits_per_key)
+{
+   if (bits_per_key == 0) bits_per_key = 1;
+   size_type new_blocks = (keys * bits_per_key + BLOCK_BITS - 1) / BLOCK_BITS;
+   if (new_blocks == 0) new_blocks = 1;
+   if (new_blocks != n_blocks)
+   {
+      delete [] storage;
+      // one cache line extra, so the blocks can start on a boundary
+      storage = new uint64_t[(new_blocks + 1) * WORDS_PER_BLOCK];
+      uintptr_t address = reinterpret_cast<uintptr_t>(storage);
+      bits = reinterpret_cast<uint64_t*>((address + BLOCK_BITS / 8 - 1)
+                                         & ~uintptr_t(BLOCK_BITS / 8 - 1));
+      n_blocks = new_blocks;
+   }
+   n_probes = unsigned(bits_per_key * log(2.0) + 0.5);
+   if (n_probes < 1) n_probes = 1;
+   if (n_probes > 16) n_probes = 16;
+   clear();
+}
+
+// takes every key out of the filter (keeping its size)
+void BloomFilter::clear()
+{
+   if (bits != 0)
+      memset(bits, 0, n_blocks * WORDS_PER_BLOCK * sizeof(uint64_t));
+   n_keys = 0;
+}
+
+// returns the bits to the heap, leaving a filter that has never been
+// reset (and lets every key through)
+void BloomFilter::release()
+{
+   delete [] storage;
+   storage = bits = 0;
+   n_blocks = 0;
+   n_probes = 0;
+   n_keys = 0;
+}
+
+// exchanges the bits (and keys) of this filter and other
+void BloomFilter::swap(BloomFilter& other)
+{
+   std::swap(storage, other.storage);
+   std::swap(bits, other.bits);
+   std::swap(n_blocks, other.n_blocks);
+   std::swap(n_probes, other.n_probes);
+   std::swap(n_keys, other.n_keys);
+}
+
+// returns true if the filter has no bits (has never been reset)
+bool BloomFilter::empty() const
+{ return n_blocks == 0; }
+
+// returns the # of blocks (cache lines) of bits
+BloomFilter::size_type BloomFilter::blocks() const
+{ return n_blocks; }
+
+// returns the # of bits a key sets in its block
+unsigned BloomFilter::probes() const
+{ return n_probes; }
+
+// returns the # of keys added since the filter was last reset
+BloomFilter::size_type BloomFilter::keys() const
+{ return n_keys; }
+
+// returns the # of heap bytes the bits take up
+BloomFilter::size_type BloomFilter::memory_used() const
+{ return n_blocks == 0 ? 0 : (n_blocks + 1) * BLOCK_BITS / 8; }
+
+// returns the probability that a key not added passes the filter,
+// given the keys added so far: the keys a block is picked by are
+// (about) Poisson distributed, and a block picked by j of them fails
+// a test with probability (1 - (1 - 1/BLOCK_BITS)^(j * probes()))
+// ^ probes(), so the rate is that averaged over j
+double BloomFilter::false_positive_rate() const
+{
+   if (n_blocks == 0)
+      return 1;
+   double lambda = double(n_keys) / n_blocks;
+   double miss = log(1 - 1.0 / BLOCK_BITS);
+   double rate = 0;
+   size_type last = size_type(lambda + 10 * sqrt(lambda) + 10);
+   for (size_type j = 0; j <= last; ++j)
+   {
+      double weight = exp(j * (lambda > 0 ? log(lambda) : 0) - lambda
+                          - lgamma(j + 1.0));
+      if (lambda == 0 && j > 0) weight = 0;
+      rate += weight * pow(1 - exp(miss * j * n_probes), double(n_probes));
+   }
+   return rate;
+}
@@ -0,0 +1,84 @@
+#ifndef BLOOM_FILTER
+#define BLOOM_FILTER
+
+#include <cstdlib>  // for use of size_t
+#include <cstdint>  // for use of uint32_t, uint64_t
+
+// a blocked Bloom filter over 32-bit key hashes: the bits are split
+// into blocks of one cache line (BLOCK_BITS bits), a key picks one
+// block and sets (or tests) its probes() bits there only, so a test
+// costs one cache miss at most, whatever the # of bits per key; a
+// test never fails for a key that was added, and passes for a key
+// that was not with (about) false_positive_rate() probability
+// (keys cannot be taken out; reset starts over with no keys)
+class BloomFilter
+{
+public:
+   typedef size_t size_type;
+   static const size_type BLOCK_BITS = 512;
+   BloomFilter();
+   ~BloomFilter();
+   void reset(size_type keys, unsigned bits_per_key);
+   void clear();
+   void release();
+   void swap(BloomFilter& other);
+   bool empty() const;
+   size_type blocks() const;
+   unsigned probes() const;
+   size_type keys() const;
+   size_type memory_used() const;
+   double false_positive_rate() const;
+   // adds the key whose hash value is key_hash
+   void add(uint32_t key_hash)
+   {
+      if (n_blocks == 0) return;
+      uint64_t h = spread(key_hash);
+      uint64_t* block = bits + block_of(h) * WORDS_PER_BLOCK;
+      uint32_t pos = uint32_t(h >> 32), step = uint32_t(h >> 41) | 1;
+      for (unsigned i = 0; i < n_probes; ++i, pos += step)
+         block[(pos & (BLOCK_BITS - 1)) / 64] |= uint64_t(1) << (pos & 63);
+      n_keys++;
+   }
+   // returns false if the key whose hash value is key_hash has
+   // certainly not been added, otherwise returns true
+   bool may_contain(uint32_t key_hash) const
+   {
+      if (n_blocks == 0) return true;
+      uint64_t h = spread(key_hash);
+      const uint64_t* block = bits + block_of(h) * WORDS_PER_BLOCK;
+      uint64_t want[WORDS_PER_BLOCK] = { 0 }; // (all bits tested at once)
+      uint32_t pos = uint32_t(h >> 32), step = uint32_t(h >> 41) | 1;
+      for (unsigned i = 0; i < n_probes; ++i, pos += step)
+         want[(pos & (BLOCK_BITS - 1)) / 64] |= uint64_t(1) << (pos & 63);
+      uint64_t missing = 0;
+      for (size_type w = 0; w < WORDS_PER_BLOCK; ++w)
+         missing |= want[w] & ~block[w];
+      return missing == 0;
+   }
+private:
+   static const size_type WORDS_PER_BLOCK = BLOCK_BITS / 64;
+   uint64_t* storage;    // the bits, with room to align them
+   uint64_t* bits;       // n_blocks blocks, each starting a cache line
+   size_type n_blocks;
+   unsigned n_probes;    // # of bits set per key
+   size_type n_keys;     // # of keys added since reset
+
+   // returns key_hash with its bits spread over 64 bits (the
+   // splitmix64 finalizer), the low 32 choosing the block and the
+   // high 32 the bits within it
+   static uint64_t spread(uint32_t key_hash)
+   {
+      uint64_t h = key_hash + 0x9E3779B97F4A7C15ull;
+      h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+      h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+      return h ^ (h >> 31);
+   }
+   size_type block_of(uint64_t h) const
+   { return size_type((uint64_t(uint32_t(h)) * n_blocks) >> 32); }
+
+   // disable copy construction & copy assignment
+   BloomFilter(const BloomFilter& src);
+   void operator=(const BloomFilter& rhs);
+};
+
+#endif
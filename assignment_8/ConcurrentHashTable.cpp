@@ -0,0 +1,152 @@
+#include "ConcurrentHashTable.h"
+#include <thread>   // for use of this_thread
+#include <functional>
+using namespace std;
+
+// returns options with incremental rehashing and statistics (which
+// searches would update) turned off
+static HashTable::Options reader_safe(HashTable::Options options)
+{
+   options.incremental_rehash = false;
+   options.collect_stats = false;
+   return options;
+}
+
+// constructs an empty hash table (two empty replicas)
+ConcurrentHashTable::ConcurrentHashTable(size_type initial_capacity,
+                                         const HashTable::Options& options)
+   : left(initial_capacity, reader_safe(options)),
+     right(initial_capacity, reader_safe(options)),
+     current(0), version(0)
+{
+   replica[0] = &left;
+   replica[1] = &right;
+   for (int v = 0; v < 2; ++v)
+      for (size_type i = 0; i < READ_SLOTS; ++i)
+         readers[v][i].count.store(0);
+}
+
+// registers the calling thread as a reader and returns the version
+// it registered in, setting slot to the read count it used
+int ConcurrentHashTable::read_begin(size_type& slot) const
+{
+   static thread_local size_type my_slot =
+      hash<thread::id>()(this_thread::get_id()) % READ_SLOTS;
+   slot = my_slot;
+   int v = version.load();
+   readers[v][slot].count.fetch_add(1);
+   return v;
+}
+
+// unregisters a reader registered by read_begin
+void ConcurrentHashTable::read_end(int v, size_type slot) const
+{ readers[v][slot].count.fetch_sub(1); }
+
+// returns once no reader is registered in version v
+void ConcurrentHashTable::wait_for_readers(int v) const
+{
+   for (size_type i = 0; i < READ_SLOTS; ++i)
+      while (readers[v][i].count.load() != 0)
+         this_thread::yield();
+}
+
+// makes the idle replica (already changed by the writer) current,
+// then returns once no reader can still be using the replica that
+// was current before, so the writer can change that one in turn
+void ConcurrentHashTable::publish()
+{
+   current.store(1 - current.load());
+   int prev = version.load();
+   int next = 1 - prev;
+   wait_for_readers(next);
+   version.store(next);
+   wait_for_readers(prev);
+}
+
+// returns the # of words in the hash table
+ConcurrentHashTable::size_type ConcurrentHashTable::size() const
+{
+   size_type slot;
+   int v = read_begin(slot);
+   size_type n = replica[current.load()]->size();
+   read_end(v, slot);
+   return n;
+}
+
+// returns true if cStr is in the hash table, otherwise returns false
+// (any number of threads may search at once, also while a thread is
+// inserting; a search never waits)
+bool ConcurrentHashTable::search(const char* cStr) const
+{
+   size_type slot;
+   int v = read_begin(slot);
+   bool found = replica[current.load()]->search(cStr);
+   read_end(v, slot);
+   return found;
+}
+
+// out[i] is set to search(words[i]) for each of the n words (see
+// HashTable::search_batch)
+void ConcurrentHashTable::search_batch(const char* const* words, size_type n,
+                                       bool* out) const
+{
+   size_type slot;
+   int v = read_begin(slot);
+   replica[current.load()]->search_batch(words, n, out);
+   read_end(v, slot);
+}
+
+// cStr is inserted unless it already exists in the hash table;
+// returns true if cStr was inserted, otherwise returns false
+// (inserting threads take turns)
+bool ConcurrentHashTable::insert_if_absent(const char* cStr)
+{
+   lock_guard<mutex> guard(write_lock);
+   int cur = current.load();
+   if ( ! replica[1 - cur]->insert_if_absent(cStr) )
+      return false;
+   publish();
+   replica[cur]->insert_if_absent(cStr);
+   return true;
+}
+
+// cStr is removed if it is in the hash table; returns true if cStr
+// was removed, otherwise returns false (see HashTable::erase)
+bool ConcurrentHashTable::erase(const char* cStr)
+{
+   lock_guard<mutex> guard(write_lock);
+   int cur = current.load();
+   if ( ! replica[1 - cur]->erase(cStr) )
+      return false;
+   publish();
+   replica[cur]->erase(cStr);
+   return true;
+}
+
+// the n words are inserted (see HashTable::insert_range), becoming
+// visible to searches all at once; returns the # of words inserted
+ConcurrentHashTable::size_type
+ConcurrentHashTable::insert_range(const char* const* words, size_type n)
+{
+   lock_guard<mutex> guard(write_lock);
+   int cur = current.load();
+   size_type inserted = replica[1 - cur]->insert_range(words, n);
+   if (inserted == 0)
+      return 0;
+   publish();
+   replica[cur]->insert_range(words, n);
+   return inserted;
+}
+
+// loads the dictionary file filename (see HashTable::load_mapped),
+// its words becoming visible to searches all at once; returns false
+// if the file cannot be loaded, otherwise returns true
+bool ConcurrentHashTable::load_mapped(const char* filename)
+{
+   lock_guard<mutex> guard(write_lock);
+   int cur = current.load();
+   if ( ! replica[1 - cur]->load_mapped(filename) )
+      return false;
+   publish();
+   return replica[cur]->load_mapped(filename);
+}
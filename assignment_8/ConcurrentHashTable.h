@@ -0,0 +1,56 @@
+#ifndef CONCURRENT_HASH_TABLE
+#define CONCURRENT_HASH_TABLE
+
+#include <atomic>   // for use of atomic
+#include <mutex>    // for use of mutex
+#include "HashTable.h"
+
+// a HashTable that any number of threads can search at once, without
+// locking, while other threads insert into it
+// two replicas of the hash table are kept (the "left-right" scheme):
+// readers use whichever one is current, and a writer, holding the
+// write lock, changes the other one, makes it current, waits for the
+// readers still on the old one to leave it, and then makes the same
+// change there; a rehash thus only ever happens on the replica no
+// reader is using, and searches never wait
+class ConcurrentHashTable
+{
+public:
+   typedef HashTable::size_type size_type;
+   // options.incremental_rehash and options.collect_stats are
+   // ignored: an incremental rehash moves items, and statistics are
+   // counted, during searches, which readers must not do
+   ConcurrentHashTable(size_type initial_capacity = HashTable::INIT_CAP,
+                       const HashTable::Options& options = HashTable::Options());
+   size_type size() const;
+   bool search(const char* cStr) const;
+   void search_batch(const char* const* words, size_type n, bool* out) const;
+   bool insert_if_absent(const char* cStr);
+   bool erase(const char* cStr);
+   size_type insert_range(const char* const* words, size_type n);
+   bool load_mapped(const char* filename);
+private:
+   static const size_type READ_SLOTS = 16;
+   // # of readers in a read section, spread over cache lines
+   struct alignas(64) ReadCount
+   {
+      std::atomic<long> count;
+   };
+   HashTable left, right;
+   HashTable* replica[2];
+   std::atomic<int> current;          // replica readers are to use
+   std::atomic<int> version;          // read counts readers register in
+   mutable ReadCount readers[2][READ_SLOTS];
+   std::mutex write_lock;
+
+   int read_begin(size_type& slot) const;
+   void read_end(int v, size_type slot) const;
+   void wait_for_readers(int v) const;
+   void publish();
+
+   // disable copy construction & copy assignment
+   ConcurrentHashTable(const ConcurrentHashTable& src);
+   void operator=(const ConcurrentHashTable& rhs);
+};
+
+#endif
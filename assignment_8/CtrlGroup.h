@@ -0,0 +1,79 @@
+#ifndef CTRL_GROUP
+#define CTRL_GROUP
+
+#include <cstdlib>  // for use of size_t
+#include <cstdint>  // for use of int8_t, uint32_t
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// one control byte is kept per hash-table slot:
+//   CTRL_EMPTY      the slot is vacant (ends a probe sequence)
+//   CTRL_DELETED    the slot is vacant, but its item has been moved
+//                   or removed (probe sequences continue past it)
+//   0 .. 127        the slot is in use; the value is a 7-bit tag
+//                   taken from the hash of the word in the slot
+// the control bytes of GROUP_WIDTH consecutive slots are examined
+// together, with one SSE2 compare when available (a byte-by-byte
+// loop otherwise), so that a probe only has to look at the slots
+// whose tag matches the one being searched for
+static const int8_t CTRL_EMPTY = -128;
+static const int8_t CTRL_DELETED = -2;
+static const size_t GROUP_WIDTH = 16;
+
+// returns the 7-bit control-byte tag for a (full) hash value
+inline int8_t ctrl_tag(uint32_t hash)
+{ return int8_t((hash * 0x9E3779B1u) >> 25); }
+
+// returns the index of the lowest set bit of a non-zero mask
+inline unsigned lowest_bit(uint32_t mask)
+{ return unsigned(__builtin_ctz(mask)); }
+
+// a view of GROUP_WIDTH consecutive control bytes; bit k of each
+// mask returned refers to the k-th byte of the group
+class CtrlGroup
+{
+public:
+   explicit CtrlGroup(const int8_t* pos)
+#ifdef __SSE2__
+      : bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) { }
+#else
+      : bytes(pos) { }
+#endif
+   // returns a mask of the bytes equal to tag
+   uint32_t match(int8_t tag) const
+   {
+#ifdef __SSE2__
+      return uint32_t(_mm_movemask_epi8(
+                 _mm_cmpeq_epi8(bytes, _mm_set1_epi8(tag))));
+#else
+      uint32_t mask = 0;
+      for (size_t k = 0; k < GROUP_WIDTH; ++k)
+         if (bytes[k] == tag) mask |= uint32_t(1) << k;
+      return mask;
+#endif
+   }
+   // returns a mask of the vacant slots
+   uint32_t match_empty() const { return match(CTRL_EMPTY); }
+   // returns a mask of the vacant or deleted slots (the bytes with
+   // their sign bit set)
+   uint32_t match_vacant() const
+   {
+#ifdef __SSE2__
+      return uint32_t(_mm_movemask_epi8(bytes));
+#else
+      uint32_t mask = 0;
+      for (size_t k = 0; k < GROUP_WIDTH; ++k)
+         if (bytes[k] < 0) mask |= uint32_t(1) << k;
+      return mask;
+#endif
+   }
+private:
+#ifdef __SSE2__
+   __m128i bytes;
+#else
+   const int8_t* bytes;
+#endif
+};
+
+#endif
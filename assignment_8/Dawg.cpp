@@ -0,0 +1,483 @@
+#include "Dawg.h"
+#include <cstring>       // for use of memcpy, memcmp, memset, strlen
+#include <fstream>       // for use of ofstream
+#include <algorithm>     // for use of sort, unique, min
+#include <unordered_map> // for use of unordered_map
+#include <utility>       // for use of pair
+using namespace std;
+
+// the fields of an edge
+static const uint32_t LABEL_MASK = 0xFF;
+static const uint32_t END_OF_WORD = 1u << 8; // the path up to the edge
+                                             // spells a word
+static const uint32_t LAST_EDGE = 1u << 9;   // last edge of its node
+static const int TARGET_SHIFT = 10;
+
+// layout of the header of a DAWG file (see save), with every field in
+// the byte order of the machine that wrote it; the edges follow, then
+// (if counted) the ranks and the counts
+struct DawgHeader
+{
+   char magic[8];      // DAWG_MAGIC
+   uint32_t version;   // DAWG_VERSION
+   uint32_t root;
+   uint64_t edges;
+   uint64_t words;
+   uint64_t counted;   // 1 if the words have counts, otherwise 0
+   uint64_t file_size;
+};
+static const char DAWG_MAGIC[8] = "DAWG";
+static const uint32_t DAWG_VERSION = 3;
+
+// a node of the automaton while it is built: whether a word ends
+// there, and its edges (label, node), in label order
+struct BuildNode
+{
+   bool final;
+   vector< pair<unsigned char, uint32_t> > edges;
+};
+
+// an edge of the path of the last word added that has not yet been
+// merged with an equivalent one
+struct Unchecked
+{
+   uint32_t parent;
+   uint32_t child;
+};
+
+// returns a string that two nodes have in common only if they are
+// equivalent (both final or both not, with the same edges to the same
+// (already merged) nodes)
+static string signature(const BuildNode& node)
+{
+   string sig(1, node.final ? '1' : '0');
+   for (size_t e = 0; e < node.edges.size(); ++e)
+   {
+      sig += char(node.edges[e].first);
+      sig.append(reinterpret_cast<const char*>(&node.edges[e].second),
+                 sizeof(uint32_t));
+   }
+   return sig;
+}
+
+// adds the len-character word to the vector of strings (the context)
+static void add_word(const char* word, size_t len, void* context)
+{ static_cast<vector<string>*>(context)->push_back(string(word, len)); }
+
+// constructs an automaton with no words (until build or open is
+// called)
+Dawg::Dawg()
+   : arcs(0), ranks(0), counts(0), n_edges(0), root(0), n_words(0) { }
+
+// replaces the contents of the automaton with the (non-empty) words
+// of dictionary, added in sorted order so that every node but those
+// along the path of the last word added is settled, and those are
+// merged with an equivalent node already registered (if any) as soon
+// as the next word leaves the path (Daciuk et al., "Incremental
+// construction of minimal acyclic finite-state automata"); if the
+// dictionary has counts, the ranks of the edges are worked out and
+// each word's count is kept (in the words' order); returns false
+// (leaving the automaton unchanged) if it would have more than
+// MAX_EDGES edges, otherwise returns true
+bool Dawg::build(const HashTable& dictionary)
+{
+   vector<string> words;
+   dictionary.for_each_word(add_word, &words);
+   sort(words.begin(), words.end());
+   words.erase(unique(words.begin(), words.end()), words.end());
+   if ( ! words.empty() && words[0].empty() )
+      words.erase(words.begin());
+
+   vector<BuildNode> nodes(1);
+   nodes[0].final = false;
+   unordered_map<string, uint32_t> registry;
+   vector<Unchecked> path;      // path[k] is the k-th edge of the path
+   string previous;
+   size_type added = 0;
+   for (size_type w = 0; w <= words.size(); ++w)
+   {
+      string word = w < words.size() ? words[w] : string();
+      size_type common = 0;
+      while (common < word.size() && common < previous.size() &&
+             word[common] == previous[common])
+         ++common;
+      // the edges of the previous word past the common prefix are
+      // merged, deepest first
+      for (; path.size() > common; path.pop_back())
+      {
+         Unchecked last = path.back();
+         string sig = signature(nodes[last.child]);
+         unordered_map<string, uint32_t>::iterator found = registry.find(sig);
+         if (found == registry.end())
+            registry[sig] = last.child;
+         else
+         {
+            nodes[last.parent].edges.back().second = found->second;
+            vector< pair<unsigned char, uint32_t> >().swap(nodes[last.child].edges);
+         }
+      }
+      if (word.empty())
+         continue;
+      uint32_t node = path.empty() ? 0 : path.back().child;
+      for (size_type i = common; i < word.size(); ++i)
+      {
+         BuildNode child;
+         child.final = false;
+         nodes.push_back(child);
+         uint32_t id = uint32_t(nodes.size() - 1);
+         nodes[node].edges.push_back(make_pair(uint8_t(word[i]), id));
+         Unchecked step = { node, id };
+         path.push_back(step);
+         node = id;
+      }
+      nodes[node].final = true;
+      previous = word;
+      ++added;
+   }
+
+   // each node reachable from the root gets its edges a place in the
+   // array (arcs[0] being left unused), a node only once every node
+   // with an edge to it has been placed (a topological order), so
+   // every edge leads further into the array; then the edges are
+   // filled in (the nodes merged away have no edges, so they count as
+   // no node's parent)
+   vector<uint32_t> first(nodes.size(), 0);
+   vector<uint32_t> unplaced_parents(nodes.size(), 0);
+   for (size_type id = 0; id < nodes.size(); ++id)
+      for (size_type e = 0; e < nodes[id].edges.size(); ++e)
+         unplaced_parents[nodes[id].edges[e].second]++;
+   vector<uint32_t> order;
+   vector<uint32_t> stack(1, 0);
+   uint32_t next = 1;
+   while ( ! stack.empty() )
+   {
+      uint32_t id = stack.back();
+      stack.pop_back();
+      first[id] = nodes[id].edges.empty() ? 0 : next;
+      next += uint32_t(nodes[id].edges.size());
+      if (next > MAX_EDGES)
+         return false;
+      order.push_back(id);
+      for (size_type e = 0; e < nodes[id].edges.size(); ++e)
+         if (--unplaced_parents[nodes[id].edges[e].second] == 0)
+            stack.push_back(nodes[id].edges[e].second);
+   }
+   bool counted = dictionary.has_counts();
+   vector<uint32_t> new_edges(counted ? 2 * next + added : next, 0);
+   for (size_type k = 0; k < order.size(); ++k)
+   {
+      const BuildNode& node = nodes[order[k]];
+      for (size_type e = 0; e < node.edges.size(); ++e)
+      {
+         uint32_t target = node.edges[e].second;
+         uint32_t arc = node.edges[e].first
+                        | (first[target] << TARGET_SHIFT);
+         if (nodes[target].final)
+            arc |= END_OF_WORD;
+         if (e + 1 == node.edges.size())
+            arc |= LAST_EDGE;
+         new_edges[first[order[k]] + e] = arc;
+      }
+   }
+   if (counted)
+   {
+      // a node's words are counted once those of the nodes its edges
+      // lead to are (in the reverse of the order placed), an edge's
+      // rank being the # of words through its node's earlier edges
+      uint32_t* new_ranks = &new_edges[next];
+      vector<uint32_t> below(nodes.size(), 0);
+      for (size_type k = order.size(); k-- > 0; )
+      {
+         const BuildNode& node = nodes[order[k]];
+         uint32_t sum = 0;
+         for (size_type e = 0; e < node.edges.size(); ++e)
+         {
+            uint32_t target = node.edges[e].second;
+            new_ranks[first[order[k]] + e] = sum;
+            sum += (nodes[target].final ? 1 : 0) + below[target];
+         }
+         below[order[k]] = sum;
+      }
+      uint32_t* new_counts = &new_edges[2 * next];
+      for (size_type w = 0; w < words.size(); ++w)
+         new_counts[w] = dictionary.count(words[w].c_str());
+   }
+
+   file.close();
+   owned.swap(new_edges);
+   arcs = owned.data();
+   ranks = counted ? arcs + next : 0;
+   counts = counted ? arcs + 2 * next : 0;
+   n_edges = next;
+   root = first[0];
+   n_words = added;
+   return true;
+}
+
+// writes the automaton to filename as a file that open can map back
+// in as is: a header (see DawgHeader) followed by the edges and (if
+// the words have counts) the ranks and the counts; returns true if
+// the file was written, otherwise false
+bool Dawg::save(const char* filename) const
+{
+   DawgHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, DAWG_MAGIC, sizeof(header.magic));
+   header.version = DAWG_VERSION;
+   header.root = root;
+   header.edges = n_edges;
+   header.words = n_words;
+   header.counted = counts != 0;
+   header.file_size = sizeof(header) + bytes();
+   ofstream out(filename, ios::out | ios::binary | ios::trunc);
+   out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+   out.write(reinterpret_cast<const char*>(arcs), n_edges * sizeof(uint32_t));
+   if (counts != 0)
+   {
+      out.write(reinterpret_cast<const char*>(ranks), n_edges * sizeof(uint32_t));
+      out.write(reinterpret_cast<const char*>(counts), n_words * sizeof(uint32_t));
+   }
+   out.close();
+   return ! out.fail();
+}
+
+// replaces the contents of the automaton with the one in filename
+// (written by save), which is mapped into memory and used in place;
+// every edge is checked to lead to an edge further into the array
+// (or to none), and the last one to end its node, so no walk can
+// leave the array or go round a cycle; returns false
+// (leaving the automaton unchanged) if the file cannot be mapped or
+// is not a valid DAWG file, otherwise returns true
+bool Dawg::open(const char* filename)
+{
+   MappedFile mapped;
+   if ( ! mapped.open(filename) || mapped.size() < sizeof(DawgHeader) )
+      return false;
+   DawgHeader header;
+   memcpy(&header, mapped.data(), sizeof(header));
+   if (memcmp(header.magic, DAWG_MAGIC, sizeof(header.magic)) != 0 ||
+       header.version != DAWG_VERSION ||
+       header.file_size != mapped.size() ||
+       header.edges == 0 || header.edges > MAX_EDGES ||
+       header.words > header.file_size || header.counted > 1 ||
+       header.file_size != sizeof(header) + header.edges * sizeof(uint32_t)
+                           + (header.counted ? (header.edges + header.words)
+                                               * sizeof(uint32_t) : 0) ||
+       header.root >= header.edges)
+      return false;
+   const uint32_t* new_arcs = reinterpret_cast<const uint32_t*>(
+      mapped.data() + sizeof(header));
+   for (size_type e = 1; e < header.edges; ++e)
+   {
+      uint32_t target = new_arcs[e] >> TARGET_SHIFT;
+      if (target >= header.edges || (target != 0 && target <= e))
+         return false;
+   }
+   if (header.edges > 1 && (new_arcs[header.edges - 1] & LAST_EDGE) == 0)
+      return false;
+
+   owned.clear();
+   file.swap(mapped); // (releasing whatever was mapped before)
+   arcs = new_arcs;
+   ranks = header.counted ? arcs + header.edges : 0;
+   counts = header.counted ? arcs + 2 * header.edges : 0;
+   n_edges = header.edges;
+   root = header.root;
+   n_words = header.words;
+   return true;
+}
+
+// returns the # of words
+Dawg::size_type Dawg::size() const
+{ return n_words; }
+
+// returns the # of edges (arcs[0] included)
+Dawg::size_type Dawg::edges() const
+{ return n_edges; }
+
+// returns true if the words have counts (the dictionary built from
+// had them), otherwise returns false
+bool Dawg::has_counts() const
+{ return counts != 0; }
+
+// returns the # of bytes the edges (and the ranks and counts) take up
+Dawg::size_type Dawg::bytes() const
+{ return (counts != 0 ? 2 * n_edges + n_words : n_edges) * sizeof(uint32_t); }
+
+// returns the index of the edge labelled c among those of the node
+// whose first edge is node (0 if there is none, or node is 0)
+static uint32_t edge_to(const uint32_t* arcs, uint32_t node, unsigned char c)
+{
+   for (uint32_t e = node; node != 0; ++e)
+   {
+      if ((arcs[e] & LABEL_MASK) == c)
+         return e;
+      if (arcs[e] & LAST_EDGE)
+         break;
+   }
+   return 0;
+}
+
+// returns true if cStr is one of the words, otherwise returns false
+bool Dawg::search(const char* cStr) const
+{ return search(cStr, strlen(cStr)); }
+
+// returns true if the len-character word is one of the words,
+// otherwise returns false
+bool Dawg::search(const char* word, size_type len) const
+{
+   uint32_t node = root, edge = 0;
+   for (size_type i = 0; i < len; ++i)
+   {
+      edge = edge_to(arcs, node, uint8_t(word[i]));
+      if (edge == 0)
+         return false;
+      node = arcs[edge] >> TARGET_SHIFT;
+   }
+   return edge != 0 && (arcs[edge] & END_OF_WORD) != 0;
+}
+
+// appends to out (in order) the words spelled by path followed by a
+// path from the node whose first edge is node, until out holds limit
+// words (if limit is not 0)
+static void collect(const uint32_t* arcs, uint32_t node, string& path,
+                    vector<string>& out, size_t limit)
+{
+   for (uint32_t e = node; node != 0; ++e)
+   {
+      if (limit != 0 && out.size() >= limit)
+         return;
+      path += char(arcs[e] & LABEL_MASK);
+      if (arcs[e] & END_OF_WORD)
+         out.push_back(path);
+      collect(arcs, arcs[e] >> TARGET_SHIFT, path, out, limit);
+      path.erase(path.size() - 1);
+      if (arcs[e] & LAST_EDGE)
+         break;
+   }
+}
+
+// out is set to the words (in order) that start with prefix (prefix
+// itself included), up to limit of them if limit is not 0; returns
+// the # of words in out
+Dawg::size_type Dawg::complete(const char* prefix, vector<string>& out,
+                               size_type limit) const
+{
+   out.clear();
+   string path(prefix);
+   uint32_t node = root, edge = 0;
+   for (size_type i = 0; i < path.size(); ++i)
+   {
+      edge = edge_to(arcs, node, uint8_t(path[i]));
+      if (edge == 0)
+         return 0;
+      node = arcs[edge] >> TARGET_SHIFT;
+   }
+   if (edge != 0 && (arcs[edge] & END_OF_WORD))
+      out.push_back(path);
+   collect(arcs, node, path, out, limit);
+   if (limit != 0 && out.size() > limit)
+      out.resize(limit);
+   return out.size();
+}
+
+// the state of a walk looking for the words near a word: row d of
+// rows (of len + 1 entries) holds the edit distances between the
+// first d characters of path and each prefix of the word
+struct NearWalk
+{
+   const uint32_t* arcs;
+   const uint32_t* ranks;   // (0 if the words have no counts)
+   const uint32_t* counts;
+   size_t n_words;
+   const char* word;
+   size_t len;
+   unsigned max_distance;
+   string path;
+   vector<unsigned> rows;
+   vector<string>* out;
+   vector<uint32_t>* out_counts; // (0 if not wanted)
+   size_t rows_made;
+};
+
+// extends the walk along every edge of the node whose first edge is
+// node, working out the next row of distances for each (with the
+// substitutions, insertions, deletions and transpositions of adjacent
+// characters an edit may be) and going on only while some entry of
+// it is within max_distance; base is the # of words (in order) that
+// come before those the walk goes on to (which, with counts, gives
+// each word found its place in counts)
+static void walk_near(NearWalk& w, uint32_t node, uint32_t base)
+{
+   size_t depth = w.path.size(), width = w.len + 1;
+   if (w.rows.size() < (depth + 2) * width)
+      w.rows.resize((depth + 2) * width);
+   for (uint32_t e = node; node != 0; ++e)
+   {
+      char c = char(w.arcs[e] & LABEL_MASK);
+      const unsigned* prev = &w.rows[depth * width];
+      unsigned* row = &w.rows[(depth + 1) * width];
+      row[0] = unsigned(depth + 1);
+      unsigned lowest = row[0];
+      for (size_t j = 1; j <= w.len; ++j)
+      {
+         unsigned best = min(prev[j] + 1, row[j - 1] + 1);
+         best = min(best, prev[j - 1] + (w.word[j - 1] == c ? 0 : 1));
+         if (depth > 0 && j > 1 && w.word[j - 1] == w.path[depth - 1] &&
+             w.word[j - 2] == c)
+            best = min(best, w.rows[(depth - 1) * width + j - 2] + 1);
+         row[j] = best;
+         lowest = min(lowest, best);
+      }
+      ++w.rows_made;
+      if (lowest <= w.max_distance)
+      {
+         uint32_t rank = w.ranks != 0 ? base + w.ranks[e] : 0;
+         bool ends_word = (w.arcs[e] & END_OF_WORD) != 0;
+         w.path += c;
+         if (ends_word && row[w.len] <= w.max_distance)
+         {
+            w.out->push_back(w.path);
+            if (w.out_counts != 0)
+               w.out_counts->push_back(w.ranks != 0 && rank < w.n_words
+                                       ? w.counts[rank] : 0);
+         }
+         walk_near(w, w.arcs[e] >> TARGET_SHIFT, rank + (ends_word ? 1 : 0));
+         w.path.erase(depth);
+      }
+      if (w.arcs[e] & LAST_EDGE)
+         break;
+   }
+}
+
+// out is set to the words (in order) within max_distance edits
+// (substitutions, insertions, deletions or transpositions of adjacent
+// characters, with no character edited twice) of word, word itself
+// included if it is one, and out_counts (if not 0) to their counts
+// (0s if the words have none), found along the way rather than
+// looked up; returns the # of rows of distances worked out (about
+// the # of nodes visited)
+Dawg::size_type Dawg::near(const char* word, unsigned max_distance,
+                           vector<string>& out,
+                           vector<uint32_t>* out_counts) const
+{
+   out.clear();
+   if (out_counts != 0)
+      out_counts->clear();
+   NearWalk w;
+   w.arcs = arcs;
+   w.ranks = ranks;
+   w.counts = counts;
+   w.n_words = n_words;
+   w.out_counts = out_counts;
+   w.word = word;
+   w.len = strlen(word);
+   w.max_distance = max_distance;
+   w.out = &out;
+   w.rows_made = 0;
+   w.rows.resize(2 * (w.len + 1));
+   for (size_t j = 0; j <= w.len; ++j)
+      w.rows[j] = unsigned(j);
+   walk_near(w, root, 0);
+   return w.rows_made;
+}
@@ -0,0 +1,69 @@
+#ifndef DAWG
+#define DAWG
+
+#include <cstdlib>  // for use of size_t
+#include <cstdint>  // for use of uint32_t
+#include <string>   // for use of string
+#include <vector>   // for use of vector
+#include "HashTable.h"
+#include "MappedFile.h"
+
+// the words of a dictionary as a minimized acyclic automaton (a DAWG,
+// or DAFSA): the words are paths of labelled edges from the root, and
+// the nodes reached by the same set of word endings are merged, so
+// shared prefixes and shared suffixes alike are stored once
+// each edge is one 32-bit value: its label (a byte), a flag set if
+// the path up to it spells a word, a flag set on the last edge of a
+// node, and the index of the first edge of the node it leads to (0
+// for a node with no edges); a node's edges lie together, in label
+// order, so the edge array is the whole automaton, which save writes
+// and open maps back in as is
+// besides membership, the automaton lists the words with a given
+// prefix and the words within a few edits of a given word, walking
+// only the paths that can still lead to one
+// if the dictionary has counts, each edge also has a rank, the # of
+// words through the earlier edges of its node, so a walk knows each
+// word's place in order (the sum of the ranks along its path, plus
+// the words ending on the way) and reads its count from an array of
+// the counts in that order, with no lookup in the dictionary
+class Dawg
+{
+public:
+   typedef size_t size_type;
+   // most edges an automaton can have (targets have 22 bits)
+   static const size_type MAX_EDGES = size_type(1) << 22;
+   Dawg();
+   bool build(const HashTable& dictionary);
+   bool save(const char* filename) const;
+   bool open(const char* filename);
+   size_type size() const;
+   size_type edges() const;
+   size_type bytes() const;
+   bool has_counts() const;
+   bool search(const char* cStr) const;
+   bool search(const char* word, size_type len) const;
+   size_type complete(const char* prefix, std::vector<std::string>& out,
+                      size_type limit = 0) const;
+   size_type near(const char* word, unsigned max_distance,
+                  std::vector<std::string>& out,
+                  std::vector<uint32_t>* out_counts = 0) const;
+private:
+   std::vector<uint32_t> owned; // the edges, ranks and counts, if
+                                // built (not opened)
+   MappedFile file;             // the file opened, if any
+   const uint32_t* arcs;        // the edges (arcs[0] is unused)
+   const uint32_t* ranks;       // ranks[e] is edge e's rank (0 if the
+                                // words have no counts)
+   const uint32_t* counts;      // the words' counts, in the words'
+                                // order (0 if they have none)
+   size_type n_edges;           // # of edges, arcs[0] included
+   uint32_t root;               // index of the root's first edge (0 if
+                                // there are no words)
+   size_type n_words;
+
+   // disable copy construction & copy assignment
+   Dawg(const Dawg& src);
+   void operator=(const Dawg& rhs);
+};
+
+#endif
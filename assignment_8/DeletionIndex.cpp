@@ -0,0 +1,220 @@
+#include "DeletionIndex.h"
+#include <algorithm> // for use of sort, unique
+#include <utility>   // for use of pair
+using namespace std;
+
+// builds the index of the words of dictionary, for lookups of up to
+// max_distance edits
+DeletionIndex::DeletionIndex(const HashTable& dictionary, unsigned max_distance)
+   : max_dist(max_distance)
+{
+   starts.push_back(0);
+   dictionary.for_each_word(add_word, this);
+
+   // one (deletion hash, word id) pair for every distinct deletion of
+   // every word, sorted so the words sharing a hash are together
+   vector< pair<uint32_t, uint32_t> > pairs;
+   vector<string> variants;
+   vector<uint32_t> hashes;
+   for (size_type id = 0; id + 1 < starts.size(); ++id)
+   {
+      string word(text.data() + starts[id], starts[id + 1] - starts[id]);
+      deletions(word, max_dist, variants);
+      hashes.clear();
+      for (size_type v = 0; v < variants.size(); ++v)
+         hashes.push_back(variant_hash(variants[v]));
+      sort(hashes.begin(), hashes.end());
+      hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+      for (size_type h = 0; h < hashes.size(); ++h)
+         pairs.push_back(make_pair(hashes[h], uint32_t(id)));
+   }
+   sort(pairs.begin(), pairs.end());
+
+   sources.reserve(pairs.size());
+   for (size_type i = 0; i < pairs.size(); ++i)
+   {
+      if (i == 0 || pairs[i].first != pairs[i - 1].first)
+         firsts.push_back(uint32_t(i));
+      sources.push_back(pairs[i].second);
+   }
+   size_type n_groups = firsts.size();
+   firsts.push_back(uint32_t(pairs.size()));
+
+   size_type capacity = 16;
+   while (capacity < 2 * n_groups) capacity *= 2;
+   keys.assign(capacity, 0);
+   groups.assign(capacity, 0);
+   for (size_type g = 0; g < n_groups; ++g)
+   {
+      uint32_t hash = pairs[firsts[g]].first;
+      size_type b = hash & (capacity - 1);
+      while (groups[b] != 0) b = (b + 1) & (capacity - 1);
+      keys[b] = hash;
+      groups[b] = uint32_t(g + 1);
+   }
+}
+
+// returns the greatest # of edits a lookup can allow
+unsigned DeletionIndex::max_distance() const
+{ return max_dist; }
+
+// returns the # of words indexed
+DeletionIndex::size_type DeletionIndex::words() const
+{ return starts.size() - 1; }
+
+// returns the # of (word, distinct deletion hash) pairs indexed
+DeletionIndex::size_type DeletionIndex::variants() const
+{ return sources.size(); }
+
+// returns the # of bytes the index takes up
+DeletionIndex::size_type DeletionIndex::memory_used() const
+{
+   return text.capacity() * sizeof(char)
+          + (starts.capacity() + sources.capacity() + firsts.capacity()
+             + keys.capacity() + groups.capacity()) * sizeof(uint32_t);
+}
+
+// out is set to the dictionary words (other than word itself) that
+// are within distance edits of word (distance no more than
+// max_distance()), sorted; returns the # of dictionary words checked
+DeletionIndex::size_type DeletionIndex::lookup(const char* word,
+                                               vector<string>& out,
+                                               unsigned distance) const
+{
+   out.clear();
+   if (distance > max_dist)
+      distance = max_dist;
+   string input(word);
+   vector<string> variants;
+   deletions(input, distance, variants);
+   vector<uint32_t> candidates;
+   for (size_type v = 0; v < variants.size(); ++v)
+   {
+      size_type g = group_of(variant_hash(variants[v]));
+      if (g == firsts.size())
+         continue;
+      candidates.insert(candidates.end(), sources.begin() + firsts[g],
+                        sources.begin() + firsts[g + 1]);
+   }
+   sort(candidates.begin(), candidates.end());
+   candidates.erase(unique(candidates.begin(), candidates.end()),
+                    candidates.end());
+   for (size_type c = 0; c < candidates.size(); ++c)
+   {
+      const char* cand = text.data() + starts[candidates[c]];
+      size_type len = starts[candidates[c] + 1] - starts[candidates[c]];
+      if (edit_distance(input.data(), input.size(), cand, len, distance) <= distance
+          && input.compare(0, string::npos, cand, len) != 0)
+         out.push_back(string(cand, len));
+   }
+   sort(out.begin(), out.end());
+   return candidates.size();
+}
+
+// same as above, allowing max_distance() edits
+DeletionIndex::size_type DeletionIndex::lookup(const char* word,
+                                               vector<string>& out) const
+{ return lookup(word, out, max_dist); }
+
+// appends the len-character word to the index's words
+// (a HashTable::word_visitor, context being the index)
+void DeletionIndex::add_word(const char* word, size_type len, void* context)
+{
+   DeletionIndex* index = static_cast<DeletionIndex*>(context);
+   index->text.insert(index->text.end(), word, word + len);
+   index->starts.push_back(uint32_t(index->text.size()));
+}
+
+// out is set to the distinct strings made by deleting up to distance
+// characters of word, word itself included
+void DeletionIndex::deletions(const string& word, unsigned distance,
+                              vector<string>& out)
+{
+   out.clear();
+   out.push_back(word);
+   size_type level_beg = 0;
+   for (unsigned d = 0; d < distance; ++d)
+   {
+      size_type level_end = out.size();
+      for (size_type v = level_beg; v < level_end; ++v)
+         for (size_type x = 0; x < out[v].size(); ++x)
+         {
+            if (x > 0 && out[v][x] == out[v][x - 1])
+               continue; // same as deleting the one before
+            string shorter(out[v]);
+            shorter.erase(x, 1);
+            out.push_back(shorter);
+         }
+      sort(out.begin() + level_end, out.end());
+      out.erase(unique(out.begin() + level_end, out.end()), out.end());
+      level_beg = level_end;
+   }
+}
+
+// returns the hash value of a deletion
+uint32_t DeletionIndex::variant_hash(const string& variant)
+{ return hash_word(HashTable::WY_HASH, variant.data(), variant.size()); }
+
+// returns the group of the deletions whose hash value is hash, or
+// firsts.size() if there is none
+DeletionIndex::size_type DeletionIndex::group_of(uint32_t hash) const
+{
+   size_type mask = keys.size() - 1;
+   for (size_type b = hash & mask; groups[b] != 0; b = (b + 1) & mask)
+      if (keys[b] == hash)
+         return groups[b] - 1;
+   return firsts.size();
+}
+
+// returns the Damerau-Levenshtein distance (the least # of
+// substitutions, insertions, deletions and transpositions of adjacent
+// characters that make one into the other) between the a_len
+// characters at a and the b_len characters at b, or limit + 1 if it
+// is more than limit
+// (Lowrance and Wagner's algorithm: h(i, j) is the distance between
+// the first i characters of a and the first j of b, shifted by one
+// row and column to make room for a border of "infinite" distances)
+unsigned edit_distance(const char* a, size_t a_len, const char* b,
+                       size_t b_len, unsigned limit)
+{
+   if ((a_len > b_len ? a_len - b_len : b_len - a_len) > limit)
+      return limit + 1;
+   size_t width = b_len + 2;
+   unsigned infinity = unsigned(a_len + b_len);
+   vector<unsigned> h((a_len + 2) * width);
+   size_t last_row[256] = { 0 }; // last row of a holding each character
+   h[0] = infinity;
+   for (size_t i = 0; i <= a_len; ++i)
+   {
+      h[(i + 1) * width] = infinity;
+      h[(i + 1) * width + 1] = unsigned(i);
+   }
+   for (size_t j = 0; j <= b_len; ++j)
+   {
+      h[j + 1] = infinity;
+      h[width + j + 1] = unsigned(j);
+   }
+   for (size_t i = 1; i <= a_len; ++i)
+   {
+      size_t last_col = 0; // last column of b matching a[i - 1]
+      for (size_t j = 1; j <= b_len; ++j)
+      {
+         size_t i1 = last_row[(unsigned char)b[j - 1]];
+         size_t j1 = last_col;
+         unsigned cost = 1;
+         if (a[i - 1] == b[j - 1])
+         {
+            cost = 0;
+            last_col = j;
+         }
+         unsigned best = min(h[i * width + j] + cost,
+                             min(h[(i + 1) * width + j], h[i * width + j + 1]) + 1);
+         best = min(best, unsigned(h[i1 * width + j1] + (i - i1 - 1) + 1
+                                   + (j - j1 - 1)));
+         h[(i + 1) * width + j + 1] = best;
+      }
+      last_row[(unsigned char)a[i - 1]] = i;
+   }
+   unsigned distance = h[(a_len + 1) * width + b_len + 1];
+   return distance > limit ? limit + 1 : distance;
+}
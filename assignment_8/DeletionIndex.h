@@ -0,0 +1,63 @@
+#ifndef DELETION_INDEX
+#define DELETION_INDEX
+
+#include <cstdint>  // for use of uint32_t
+#include <string>   // for use of string
+#include <vector>   // for use of vector
+#include "HashTable.h"
+
+// a SymSpell-style index of the words of a dictionary (a HashTable)
+// by their deletion neighborhoods: every string made by deleting up
+// to max_distance characters of a word (the word itself included)
+// leads back to that word; two words are within max_distance edits
+// (substitutions, insertions, deletions or transpositions) of each
+// other only if they share such a string, so a fuzzy lookup only has
+// to hash the deletions of the word looked up and check the few
+// dictionary words they lead to, instead of generating and looking up
+// every word max_distance edits away
+// the strings themselves are not kept, only their (32-bit) hash
+// values, which is why every word found is checked
+class DeletionIndex
+{
+public:
+   typedef size_t size_type;
+   explicit DeletionIndex(const HashTable& dictionary,
+                          unsigned max_distance = 2);
+   unsigned max_distance() const;
+   size_type words() const;
+   size_type variants() const;
+   size_type memory_used() const;
+   size_type lookup(const char* word, std::vector<std::string>& out,
+                    unsigned distance) const;
+   size_type lookup(const char* word, std::vector<std::string>& out) const;
+private:
+   unsigned max_dist;
+   std::vector<char> text;        // the words, back to back
+   std::vector<uint32_t> starts;  // word i is text[starts[i]] up to
+                                  // text[starts[i + 1]]
+   std::vector<uint32_t> sources; // ids of the words each distinct
+                                  // deletion hash leads to, grouped by
+                                  // hash value
+   std::vector<uint32_t> firsts;  // group g is sources[firsts[g]] up
+                                  // to sources[firsts[g + 1]]
+   std::vector<uint32_t> keys;    // open-addressed (linear probing)
+   std::vector<uint32_t> groups;  // table from a deletion hash (in
+                                  // keys) to its group + 1 (0 marks
+                                  // a vacant bucket)
+
+   static void add_word(const char* word, size_type len, void* context);
+   static void deletions(const std::string& word, unsigned distance,
+                         std::vector<std::string>& out);
+   static uint32_t variant_hash(const std::string& variant);
+   size_type group_of(uint32_t hash) const;
+
+   // disable copy construction & copy assignment
+   DeletionIndex(const DeletionIndex& src);
+   void operator=(const DeletionIndex& rhs);
+};
+
+// non-member utility function
+unsigned edit_distance(const char* a, size_t a_len, const char* b,
+                       size_t b_len, unsigned limit);
+
+#endif
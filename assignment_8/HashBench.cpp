@@ -0,0 +1,663 @@
+// FILE: HashBench.cpp
+// Compares the hash functions HashTable can use (see hash_word) on the
+// dictionaries dict0.txt and dict1.txt (or those named on the command
+// line), with each sizing policy and both probing policies (layouts
+// prime, pow2, rh-prime and rh-pow2), reporting for each:
+//   hash MB/s     hashing throughput over every word of the dictionary
+//   hit ns        time per search for a word in the dictionary
+//   near ns       time per search for the near-match candidates
+//                 Assign08 generates (every single-letter substitution)
+//   load          load-factor once the dictionary is loaded
+//   probe         average # of groups (slots, under Robin Hood
+//                 probing) probed to find a word
+//   cluster       clustering index from the scat_plot histogram: the
+//                 variance of the per-row counts over the variance
+//                 expected of a uniformly random hash (1 = random,
+//                 larger = more clustered)
+// followed by what a Bloom filter (see Options::bloom_bits) of 8, 12
+// and 16 bits per word does for searches: its size, its estimated
+// and measured false-positive rates, the hit and near ns above and
+// the time SpellSuggester takes per (misspelled) word with it, then
+// by the build time, bytes per word (besides the words, and in all)
+// and hit and near ns of the minimal perfect hash (PerfectHashTable)
+// of the dictionary against a HashTable, then
+// by the time SpellSuggester takes per (misspelled) word to
+// find the words 1 and 2 edits away, with each hash function (djb2
+// candidates are hashed incrementally, the others from scratch), with
+// a DeletionIndex (whose build time and memory are given) and by
+// walking a Dawg of the words (whose build time, memory and time per
+// search are given), then
+// by the (wall-clock) time load_parallel takes to build the
+// hash table with 1, 2, 4, ... threads, by the throughput of each
+// version (see use_kernels) of the text routines lower_ascii,
+// find_words and find_tokens on the dictionary file and the time
+// load_mapped takes with it, by the time per insertion and per
+// lookup (of a const char*) of a HashMap<string, int> holding the
+// words, against a std::unordered_map, and by the search throughput
+// of a ConcurrentHashTable holding the dictionary with 1, 2, 4, ...
+// reader threads, while one writer thread keeps inserting new words
+// run as
+//    hashbench -j [dictionaries]
+// it instead writes (as a JSON array) the statistics a hash table
+// keeps with collect_stats (see HashTable::dump_stats), with each
+// hash function and layout, after loading the dictionary and
+// searching for each of its words and for a typo of every 101st word
+// run as
+//    hashbench -l [inserts]
+// it instead times each of 2M (or the # given) insertions of new
+// words into a hash table, first without and then with
+// incremental_rehash (see Options), and reports the median, 99th
+// percentile, 99.9th percentile and worst time of one insertion and
+// the total time, so the pauses a whole-table rehash causes (and
+// what spreading it over later operations leaves of them) show
+#include "HashTable.h"
+#include "ConcurrentHashTable.h"
+#include "SpellSuggester.h"
+#include "DeletionIndex.h"
+#include "TextKernels.h"
+#include "HashMap.h"
+#include "PerfectHash.h"
+#include "Dawg.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+using namespace std;
+
+double Seconds(clock_t ticks);
+double ClusteringIndex(const HashTable& hTab);
+void BenchDictionary(const char* dictName);
+void BenchBloom(const char* dictName, const vector<string>& words,
+                const vector<string>& near);
+void BenchPerfect(const char* dictName, const vector<string>& words,
+                  const vector<string>& near);
+void BenchSuggest(const char* dictName, const vector<string>& words);
+void BenchBuild(const char* dictName);
+void BenchKernels(const char* dictName);
+void BenchMap(const char* dictName, const vector<string>& words);
+void BenchConcurrent(const char* dictName, const vector<string>& words);
+void DumpStats(const char* dictName, bool first);
+void BenchLatency(size_t inserts);
+
+int main(int argc, char* argv[])
+{
+   if (argc > 1 && strcmp(argv[1], "-j") == 0)
+   {
+      cout << "[";
+      if (argc > 2)
+         for (int i = 2; i < argc; ++i)
+            DumpStats(argv[i], i == 2);
+      else
+      {
+         DumpStats("dict0.txt", true);
+         DumpStats("dict1.txt", false);
+      }
+      cout << "\n]" << endl;
+   }
+   else if (argc > 1 && strcmp(argv[1], "-l") == 0)
+      BenchLatency(argc > 2 ? strtoull(argv[2], 0, 10) : 2000000);
+   else if (argc > 1)
+      for (int i = 1; i < argc; ++i)
+         BenchDictionary(argv[i]);
+   else
+   {
+      BenchDictionary("dict0.txt");
+      BenchDictionary("dict1.txt");
+   }
+   return EXIT_SUCCESS;
+}
+
+double Seconds(clock_t ticks)
+{ return double(ticks) / CLOCKS_PER_SEC; }
+
+// the scat_plot rows read "lo - hi: ***...", one '*' per used slot
+double ClusteringIndex(const HashTable& hTab)
+{
+   ostringstream plot;
+   hTab.scat_plot(plot);
+   istringstream rows(plot.str());
+   string row;
+   vector<double> counts, widths;
+   while (getline(rows, row))
+   {
+      size_t colon = row.find(':');
+      size_t dash = row.find(" - ");
+      if (colon == string::npos || dash == string::npos) continue;
+      double lo = atof(row.substr(0, dash).c_str());
+      double hi = atof(row.substr(dash + 3, colon - dash - 3).c_str());
+      counts.push_back(double(row.size() - colon - 2));
+      widths.push_back(hi - lo + 1);
+   }
+   double p = hTab.load_factor(), observed = 0, expected = 0;
+   for (size_t i = 0; i < counts.size(); ++i)
+   {
+      double mean = widths[i] * p;
+      observed += (counts[i] - mean) * (counts[i] - mean);
+      expected += widths[i] * p * (1 - p);
+   }
+   return expected > 0 ? observed / expected : 0;
+}
+
+void BenchDictionary(const char* dictName)
+{
+   ifstream fin(dictName, ios::in);
+   if ( fin.fail() )
+   {
+      cerr << "Failed to open dictionary file " << dictName << endl;
+      return;
+   }
+   vector<string> words;
+   string oneWord;
+   size_t bytes = 0;
+   while (fin >> oneWord)
+   {
+      words.push_back(oneWord);
+      bytes += oneWord.size();
+   }
+   fin.close();
+
+   vector<string> near;
+   for (size_t w = 0; w < words.size(); w += 7)
+      for (size_t x = 0; x < words[w].size(); ++x)
+         for (char c = 'a'; c <= 'z'; ++c)
+         {
+            string altWord = words[w];
+            altWord[x] = c;
+            near.push_back(altWord);
+         }
+
+   const char* names[] = { "djb2", "fnv1a", "wyhash" };
+   const HashTable::hash_policy policies[] =
+      { HashTable::DJB2_HASH, HashTable::FNV1A_HASH, HashTable::WY_HASH };
+   const int REPEATS = 20;
+
+   cout << dictName << ": " << words.size() << " words, "
+        << near.size() << " near-match candidates" << endl;
+   const char* layouts[] = { "prime", "pow2", "rh-prime", "rh-pow2" };
+   cout << setw(8) << "hash" << setw(9) << "layout" << setw(10) << "hash MB/s"
+        << setw(9) << "hit ns" << setw(9) << "near ns" << setw(7) << "load"
+        << setw(8) << "probe" << setw(9) << "cluster" << endl;
+   for (int h = 0; h < 3; ++h)
+      for (int s = 0; s < 4; ++s)
+      {
+         HashTable::Options options;
+         options.hasher = policies[h];
+         options.sizing = (s % 2) ? HashTable::POWER_OF_TWO_SIZING
+                                  : HashTable::PRIME_SIZING;
+         options.probing = (s / 2) ? HashTable::ROBIN_HOOD_PROBING
+                                   : HashTable::QUADRATIC_PROBING;
+
+         uint32_t sink = 0;
+         clock_t beg = clock();
+         for (int r = 0; r < REPEATS; ++r)
+            for (size_t i = 0; i < words.size(); ++i)
+               sink ^= hash_word(policies[h], words[i].data(), words[i].size());
+         double hashSecs = Seconds(clock() - beg);
+
+         HashTable hTab(HashTable::INIT_CAP, options);
+         if ( ! hTab.load_mapped(dictName) ) return;
+
+         size_t found = 0;
+         beg = clock();
+         for (int r = 0; r < REPEATS; ++r)
+            for (size_t i = 0; i < words.size(); ++i)
+               found += hTab.search(words[i].c_str());
+         double hitSecs = Seconds(clock() - beg);
+         beg = clock();
+         for (size_t i = 0; i < near.size(); ++i)
+            found += hTab.search(near[i].c_str());
+         double nearSecs = Seconds(clock() - beg);
+
+         cout << setw(8) << names[h] << setw(9) << layouts[s]
+              << fixed << setprecision(0)
+              << setw(10) << (hashSecs > 0 ? REPEATS * bytes / hashSecs / 1e6 : 0)
+              << setprecision(1)
+              << setw(9) << hitSecs * 1e9 / (REPEATS * words.size())
+              << setw(9) << nearSecs * 1e9 / near.size()
+              << setprecision(3) << setw(7) << hTab.load_factor()
+              << setw(8) << hTab.avg_probe_length()
+              << setw(9) << ClusteringIndex(hTab)
+              << (sink == 1 && found == 0 ? " " : "") << endl;
+      }
+   cout << endl;
+   BenchBloom(dictName, words, near);
+   BenchPerfect(dictName, words, near);
+   BenchSuggest(dictName, words);
+   BenchBuild(dictName);
+   BenchKernels(dictName);
+   BenchMap(dictName, words);
+   BenchConcurrent(dictName, words);
+}
+
+void BenchBloom(const char* dictName, const vector<string>& words,
+                const vector<string>& near)
+{
+   const unsigned bits[] = { 0, 8, 12, 16 };
+   const int REPEATS = 20;
+   vector<string> typos;
+   for (size_t w = 0; w < words.size(); w += 101)
+   {
+      string typo = words[w];
+      typo[typo.size() / 2] = 'q';
+      typos.push_back(typo);
+   }
+   cout << dictName << ": Bloom filter in front of searches" << endl;
+   cout << setw(8) << "bits" << setw(9) << "KB" << setw(10) << "fp est"
+        << setw(10) << "fp seen" << setw(9) << "hit ns" << setw(9) << "near ns"
+        << setw(9) << "d1 us" << endl;
+   for (int b = 0; b < 4; ++b)
+   {
+      HashTable::Options options;
+      options.bloom_bits = bits[b];
+      options.collect_stats = true;
+      HashTable hTab(HashTable::INIT_CAP, options);
+      if ( ! hTab.load_mapped(dictName) ) return;
+
+      size_t found = 0;
+      clock_t beg = clock();
+      for (int r = 0; r < REPEATS; ++r)
+         for (size_t i = 0; i < words.size(); ++i)
+            found += hTab.search(words[i].c_str());
+      double hitSecs = Seconds(clock() - beg);
+      hTab.reset_stats();
+      beg = clock();
+      for (size_t i = 0; i < near.size(); ++i)
+         found += hTab.search(near[i].c_str());
+      double nearSecs = Seconds(clock() - beg);
+      HashTable::Stats s = hTab.stats();
+      size_t negatives = s.bloom_rejects + s.bloom_false_positives;
+
+      SpellSuggester suggester(hTab);
+      vector<string> out;
+      beg = clock();
+      for (size_t i = 0; i < typos.size(); ++i)
+         found += suggester.suggest(typos[i].c_str(), out, 1);
+      double suggestSecs = Seconds(clock() - beg);
+
+      cout << setw(8) << bits[b] << setprecision(1)
+           << setw(9) << hTab.bloom_bytes() / 1e3 << setprecision(4)
+           << setw(10) << (bits[b] ? hTab.bloom_fp_rate() : 1.0)
+           << setw(10) << (negatives ? double(s.bloom_false_positives) / negatives : 1.0)
+           << setprecision(1)
+           << setw(9) << hitSecs * 1e9 / (REPEATS * words.size())
+           << setw(9) << nearSecs * 1e9 / near.size()
+           << setw(9) << suggestSecs * 1e6 / typos.size()
+           << (found == 0 ? " " : "") << endl;
+   }
+   cout << endl;
+}
+
+void BenchPerfect(const char* dictName, const vector<string>& words,
+                  const vector<string>& near)
+{
+   const int REPEATS = 20;
+   string mphName = string(dictName) + ".mph";
+   HashTable hTab;
+   if ( ! hTab.load_mapped(dictName) ) return;
+   clock_t beg = clock();
+   PerfectHashBuilder builder(hTab);
+   double buildSecs = Seconds(clock() - beg);
+   PerfectHashTable pTab;
+   if ( ! builder.save(mphName.c_str()) || ! pTab.open(mphName.c_str()) )
+   {
+      cerr << "Failed to build " << mphName << endl;
+      return;
+   }
+   size_t textBytes = 0;
+   for (size_t i = 0; i < words.size(); ++i)
+      textBytes += words[i].size() + 1;
+   cout << dictName << ": minimal perfect hash against HashTable" << endl;
+   cout << setw(10) << "table" << setw(10) << "build ms" << setw(10) << "B/word"
+        << setw(10) << "B/w all" << setw(9) << "hit ns" << setw(9) << "near ns"
+        << endl;
+   for (int kind = 0; kind < 2; ++kind)
+   {
+      size_t found = 0;
+      beg = clock();
+      for (int r = 0; r < REPEATS; ++r)
+         for (size_t i = 0; i < words.size(); ++i)
+            found += kind == 0 ? hTab.search(words[i].c_str())
+                               : pTab.search(words[i].c_str());
+      double hitSecs = Seconds(clock() - beg);
+      beg = clock();
+      for (size_t i = 0; i < near.size(); ++i)
+         found += kind == 0 ? hTab.search(near[i].c_str())
+                            : pTab.search(near[i].c_str());
+      double nearSecs = Seconds(clock() - beg);
+      // (the words of the HashTable are in the mapped dictionary file)
+      double indexBytes = kind == 0
+         ? double(hTab.stats().bytes_allocated)
+         : double(pTab.index_bytes());
+      double allBytes = kind == 0 ? indexBytes + textBytes : double(pTab.bytes());
+      cout << setw(10) << (kind == 0 ? "HashTable" : "perfect")
+           << setprecision(1) << setw(10) << (kind == 0 ? 0.0 : buildSecs * 1e3)
+           << setw(10) << indexBytes / words.size()
+           << setw(10) << allBytes / words.size()
+           << setw(9) << hitSecs * 1e9 / (REPEATS * words.size())
+           << setw(9) << nearSecs * 1e9 / near.size()
+           << (found == 0 ? " " : "") << endl;
+   }
+   remove(mphName.c_str());
+   cout << endl;
+}
+
+void BenchSuggest(const char* dictName, const vector<string>& words)
+{
+   const char* names[] = { "djb2", "fnv1a", "wyhash" };
+   const HashTable::hash_policy policies[] =
+      { HashTable::DJB2_HASH, HashTable::FNV1A_HASH, HashTable::WY_HASH };
+   // every 101st word, with its middle letter changed to 'q'
+   vector<string> typos;
+   for (size_t w = 0; w < words.size(); w += 101)
+   {
+      string typo = words[w];
+      typo[typo.size() / 2] = 'q';
+      typos.push_back(typo);
+   }
+   cout << dictName << ": suggestions for " << typos.size() << " typos" << endl;
+   cout << setw(8) << "hash" << setw(10) << "d1 us" << setw(10) << "d1 cands"
+        << setw(10) << "d2 us" << setw(10) << "d2 cands" << endl;
+   for (int h = 0; h < 3; ++h)
+   {
+      HashTable::Options options;
+      options.hasher = policies[h];
+      HashTable hTab(HashTable::INIT_CAP, options);
+      if ( ! hTab.load_mapped(dictName) ) return;
+      SpellSuggester suggester(hTab);
+      vector<string> out;
+      cout << setw(8) << names[h];
+      for (unsigned distance = 1; distance <= 2; ++distance)
+      {
+         size_t tried = 0;
+         clock_t beg = clock();
+         for (size_t i = 0; i < typos.size(); ++i)
+            tried += suggester.suggest(typos[i].c_str(), out, distance);
+         double secs = Seconds(clock() - beg);
+         cout << setprecision(1) << setw(10) << secs * 1e6 / typos.size()
+              << setprecision(0) << setw(10) << double(tried) / typos.size();
+      }
+      cout << endl;
+   }
+
+   HashTable hTab;
+   if ( ! hTab.load_mapped(dictName) ) return;
+   clock_t beg = clock();
+   DeletionIndex index(hTab, 2);
+   double buildSecs = Seconds(clock() - beg);
+   vector<string> out;
+   cout << setw(8) << "index";
+   for (unsigned distance = 1; distance <= 2; ++distance)
+   {
+      size_t checked = 0;
+      beg = clock();
+      for (size_t i = 0; i < typos.size(); ++i)
+         checked += index.lookup(typos[i].c_str(), out, distance);
+      double secs = Seconds(clock() - beg);
+      cout << setprecision(1) << setw(10) << secs * 1e6 / typos.size()
+           << setprecision(0) << setw(10) << double(checked) / typos.size();
+   }
+   cout << "  (built in " << setprecision(2) << buildSecs << " s, "
+        << index.variants() << " variants, " << setprecision(1)
+        << index.memory_used() / 1e6 << " MB)" << endl;
+
+   Dawg graph;
+   beg = clock();
+   if ( ! graph.build(hTab) ) return;
+   buildSecs = Seconds(clock() - beg);
+   SpellSuggester walker(hTab, graph);
+   cout << setw(8) << "dawg";
+   for (unsigned distance = 1; distance <= 2; ++distance)
+   {
+      size_t rows = 0;
+      beg = clock();
+      for (size_t i = 0; i < typos.size(); ++i)
+         rows += walker.suggest(typos[i].c_str(), out, distance);
+      double secs = Seconds(clock() - beg);
+      cout << setprecision(1) << setw(10) << secs * 1e6 / typos.size()
+           << setprecision(0) << setw(10) << double(rows) / typos.size();
+   }
+   const int REPEATS = 20;
+   size_t found = 0;
+   beg = clock();
+   for (int r = 0; r < REPEATS; ++r)
+      for (size_t i = 0; i < words.size(); ++i)
+         found += graph.search(words[i].c_str());
+   double hitSecs = Seconds(clock() - beg);
+   cout << "  (built in " << setprecision(2) << buildSecs << " s, "
+        << graph.edges() << " edges, " << setprecision(1)
+        << graph.bytes() / 1e6 << " MB, hit "
+        << hitSecs * 1e9 / (REPEATS * words.size()) << " ns)"
+        << (found == 0 ? " " : "") << endl;
+   cout << endl;
+}
+
+void BenchBuild(const char* dictName)
+{
+   unsigned maxThreads = thread::hardware_concurrency();
+   if (maxThreads < 4) maxThreads = 4;
+   cout << dictName << ": load_parallel build time" << endl;
+   cout << setw(8) << "threads" << setw(10) << "ms" << endl;
+   for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+   {
+      chrono::steady_clock::time_point beg = chrono::steady_clock::now();
+      HashTable hTab;
+      if ( ! hTab.load_parallel(dictName, threads) ) return;
+      double secs = chrono::duration<double>(chrono::steady_clock::now()
+                                             - beg).count();
+      cout << setw(8) << threads << setw(10) << setprecision(1)
+           << secs * 1e3 << endl;
+   }
+   cout << endl;
+}
+
+void BenchKernels(const char* dictName)
+{
+   ifstream fin(dictName, ios::in | ios::binary);
+   ostringstream contents;
+   contents << fin.rdbuf();
+   string text = contents.str();
+   string lowered(text.size(), ' ');
+   const int REPEATS = 20;
+   cout << dictName << ": text routines, " << text.size() << " bytes" << endl;
+   cout << setw(8) << "kernels" << setw(12) << "lower MB/s"
+        << setw(12) << "words MB/s" << setw(12) << "tokens MB/s"
+        << setw(10) << "load ms" << endl;
+   kernel_level best = best_kernels();
+   for (int level = SCALAR_KERNELS; level <= best; ++level)
+   {
+      use_kernels(kernel_level(level));
+      vector<WordSpan> spans;
+      double secs[3];
+      for (int k = 0; k < 3; ++k)
+      {
+         clock_t beg = clock();
+         for (int r = 0; r < REPEATS; ++r)
+         {
+            spans.clear();
+            if (k == 0)
+               lower_ascii(text.data(), &lowered[0], text.size());
+            else if (k == 1)
+               find_words(text.data(), text.size(), spans);
+            else
+               find_tokens(text.data(), text.size(), spans);
+         }
+         secs[k] = Seconds(clock() - beg);
+      }
+      clock_t beg = clock();
+      HashTable hTab;
+      if ( ! hTab.load_mapped(dictName) ) return;
+      double loadSecs = Seconds(clock() - beg);
+      cout << setw(8) << kernel_name(kernel_level(level)) << setprecision(0);
+      for (int k = 0; k < 3; ++k)
+         cout << setw(12) << (secs[k] > 0 ? REPEATS * text.size() / secs[k] / 1e6 : 0);
+      cout << setw(10) << setprecision(1) << loadSecs * 1e3 << endl;
+   }
+   use_kernels(best);
+   cout << endl;
+}
+
+void BenchMap(const char* dictName, const vector<string>& words)
+{
+   const int REPEATS = 20;
+   cout << dictName << ": word -> int maps" << endl;
+   cout << setw(15) << "map" << setw(11) << "insert ns" << setw(11) << "lookup ns"
+        << endl;
+   for (int kind = 0; kind < 2; ++kind)
+   {
+      HashMap<string, int> hMap;
+      unordered_map<string, int> uMap;
+      clock_t beg = clock();
+      for (size_t i = 0; i < words.size(); ++i)
+         if (kind == 0)
+            hMap.try_emplace(words[i], int(i));
+         else
+            uMap.emplace(words[i], int(i));
+      double insertSecs = Seconds(clock() - beg);
+      long sum = 0;
+      beg = clock();
+      for (int r = 0; r < REPEATS; ++r)
+         for (size_t i = 0; i < words.size(); ++i)
+         {
+            const char* word = words[i].c_str();
+            if (kind == 0)
+               sum += *hMap.find(word);
+            else
+               sum += uMap.find(word)->second;
+         }
+      double lookupSecs = Seconds(clock() - beg);
+      cout << setw(15) << (kind == 0 ? "HashMap" : "unordered_map")
+           << setprecision(1)
+           << setw(11) << insertSecs * 1e9 / words.size()
+           << setw(11) << lookupSecs * 1e9 / (REPEATS * words.size())
+           << (sum == -1 ? " " : "") << endl;
+   }
+   cout << endl;
+}
+
+void BenchConcurrent(const char* dictName, const vector<string>& words)
+{
+   unsigned maxReaders = thread::hardware_concurrency();
+   if (maxReaders < 4) maxReaders = 4;
+   cout << dictName << ": concurrent searches (one writer inserting)" << endl;
+   cout << setw(8) << "readers" << setw(14) << "searches/s"
+        << setw(10) << "inserts" << endl;
+   for (unsigned readers = 1; readers <= maxReaders; readers *= 2)
+   {
+      ConcurrentHashTable cTab;
+      if ( ! cTab.load_mapped(dictName) ) return;
+      atomic<bool> done(false);
+      atomic<long> searches(0);
+      vector<thread> pool;
+      for (unsigned t = 0; t < readers; ++t)
+         pool.push_back(thread([&, t]() {
+            long n = 0;
+            for (size_t i = t; ! done.load(); i += 7, ++n)
+               cTab.search(words[i % words.size()].c_str());
+            searches += n;
+         }));
+      chrono::steady_clock::time_point beg = chrono::steady_clock::now();
+      long inserts = 0;
+      char newWord[32];
+      while (chrono::steady_clock::now() - beg < chrono::milliseconds(500))
+      {
+         sprintf(newWord, "zz%ld", inserts++);
+         cTab.insert_if_absent(newWord);
+      }
+      done = true;
+      for (size_t t = 0; t < pool.size(); ++t)
+         pool[t].join();
+      double secs = chrono::duration<double>(chrono::steady_clock::now()
+                                             - beg).count();
+      cout << setw(8) << readers << setw(14) << setprecision(0)
+           << searches.load() / secs << setw(10) << inserts << endl;
+   }
+   cout << endl;
+}
+
+void DumpStats(const char* dictName, bool first)
+{
+   ifstream fin(dictName, ios::in);
+   if ( fin.fail() )
+   {
+      cerr << "Failed to open dictionary file " << dictName << endl;
+      return;
+   }
+   vector<string> words;
+   string oneWord;
+   while (fin >> oneWord)
+      words.push_back(oneWord);
+   fin.close();
+
+   const HashTable::hash_policy policies[] =
+      { HashTable::DJB2_HASH, HashTable::FNV1A_HASH, HashTable::WY_HASH };
+   for (int h = 0; h < 3; ++h)
+      for (int s = 0; s < 4; ++s)
+      {
+         HashTable::Options options;
+         options.hasher = policies[h];
+         options.sizing = (s % 2) ? HashTable::POWER_OF_TWO_SIZING
+                                  : HashTable::PRIME_SIZING;
+         options.probing = (s / 2) ? HashTable::ROBIN_HOOD_PROBING
+                                   : HashTable::QUADRATIC_PROBING;
+         options.collect_stats = true;
+         HashTable hTab(HashTable::INIT_CAP, options);
+         if ( ! hTab.load_mapped(dictName) ) return;
+         for (size_t i = 0; i < words.size(); ++i)
+            hTab.search(words[i].c_str());
+         for (size_t w = 0; w < words.size(); w += 101)
+         {
+            string typo = words[w];
+            typo[typo.size() / 2] = 'q';
+            hTab.search(typo.c_str());
+         }
+         cout << ((first && h == 0 && s == 0) ? "\n" : ",\n");
+         hTab.dump_stats(cout);
+      }
+}
+
+void BenchLatency(size_t inserts)
+{
+   cout << inserts << " insertions of new words: time per insertion"
+        << endl;
+   cout << setw(12) << "rehash" << setw(10) << "p50 ns" << setw(10)
+        << "p99 ns" << setw(12) << "p99.9 ns" << setw(12) << "max ns"
+        << setw(10) << "total s" << endl;
+   vector<double> ns(inserts);
+   char newWord[32];
+   for (int incremental = 0; incremental < 2; ++incremental)
+   {
+      HashTable::Options options;
+      options.incremental_rehash = incremental != 0;
+      HashTable hTab(HashTable::INIT_CAP, options);
+      chrono::steady_clock::time_point beg = chrono::steady_clock::now();
+      for (size_t i = 0; i < inserts; ++i)
+      {
+         sprintf(newWord, "w%zu", i);
+         chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+         hTab.insert_if_absent(newWord);
+         ns[i] = chrono::duration<double, nano>(chrono::steady_clock::now()
+                                                - t0).count();
+      }
+      double secs = chrono::duration<double>(chrono::steady_clock::now()
+                                             - beg).count();
+      // the percentiles are read off the sorted times
+      sort(ns.begin(), ns.end());
+      cout << setw(12) << (incremental ? "incremental" : "whole")
+           << fixed << setprecision(0)
+           << setw(10) << (inserts ? ns[inserts / 2] : 0)
+           << setw(10) << (inserts ? ns[size_t(inserts * 0.99)] : 0)
+           << setw(12) << (inserts ? ns[size_t(inserts * 0.999)] : 0)
+           << setw(12) << (inserts ? ns[inserts - 1] : 0)
+           << setprecision(3) << setw(10) << secs << endl;
+   }
+   cout << endl;
+}
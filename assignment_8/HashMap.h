@@ -0,0 +1,477 @@
+#ifndef HASH_MAP
+#define HASH_MAP
+
+#include <cstdlib>     // for use of size_t
+#include <cstdint>     // for use of uint32_t
+#include <cstring>     // for use of strlen
+#include <functional>  // for use of hash, equal_to
+#include <new>         // for use of placement new
+#include <string>      // for use of string
+#include <type_traits> // for use of aligned_storage
+#include <utility>     // for use of pair, move, forward
+#if __cplusplus >= 201703L
+#include <string_view> // for use of string_view
+#endif
+#include "CtrlGroup.h"
+#include "HashTable.h"
+
+// the hash function and equality test a HashMap uses by default:
+// those of the standard library, except for string keys (see below)
+template <class Key>
+struct MapHash : std::hash<Key> { };
+template <class Key>
+struct MapEqual : std::equal_to<Key> { };
+
+// for string keys, a word is hashed as HashTable hashes it (with
+// wyhash, see hash_word), and the hash function and equality test
+// also take a const char* (and, from C++17 on, a string_view), so
+// that a word can be looked up without building a string for it
+// (is_transparent marks them as taking such keys)
+template <>
+struct MapHash<std::string>
+{
+   typedef void is_transparent;
+   size_t operator()(const char* word, size_t len) const
+   { return hash_word(HashTable::WY_HASH, word, len); }
+   size_t operator()(const std::string& word) const
+   { return (*this)(word.data(), word.size()); }
+   size_t operator()(const char* word) const
+   { return (*this)(word, strlen(word)); }
+#if __cplusplus >= 201703L
+   size_t operator()(std::string_view word) const
+   { return (*this)(word.data(), word.size()); }
+#endif
+};
+template <>
+struct MapEqual<std::string>
+{
+   typedef void is_transparent;
+   bool operator()(const std::string& key, const std::string& word) const
+   { return key == word; }
+   bool operator()(const std::string& key, const char* word) const
+   { return key == word; }
+#if __cplusplus >= 201703L
+   bool operator()(const std::string& key, std::string_view word) const
+   { return key == word; }
+#endif
+};
+
+// a hash map from Key to Value laid out as a HashTable is: the
+// entries lie in one array of slots (no allocation per entry), each
+// along with a 32-bit fingerprint of its key's hash value, and are
+// found by group-wise quadratic probing over a prime # of slots,
+// guided by the control bytes of CtrlGroup.h; the slot array is
+// rebuilt, twice as big, once more than MAX_LOAD of it is in use
+// Value (and Key) need only be movable, not copyable; with a hash
+// function and equality test marked is_transparent (as those for
+// string keys are), find, contains and erase take any key they do
+// the pointers find and try_emplace return stay valid until the next
+// insertion or erase
+template <class Key, class Value, class Hash = MapHash<Key>,
+          class Eq = MapEqual<Key> >
+class HashMap
+{
+public:
+   typedef size_t size_type;
+   static const size_type INIT_CAP = HashTable::INIT_CAP;
+   explicit HashMap(size_type initial_capacity = INIT_CAP,
+                    const Hash& hash = Hash(), const Eq& eq = Eq());
+   ~HashMap();
+   size_type cap() const;
+   size_type size() const;
+   bool empty() const;
+   double load_factor() const;
+   template <class K>
+   Value* find(const K& key);
+   template <class K>
+   const Value* find(const K& key) const;
+   template <class K>
+   bool contains(const K& key) const;
+   template <class K, class... Args>
+   std::pair<Value*, bool> try_emplace(K&& key, Args&&... args);
+   bool insert(Key key, Value value);
+   Value& operator[](const Key& key);
+   template <class K>
+   bool erase(const K& key);
+   template <class Visitor>
+   void for_each(Visitor visit);
+   template <class Visitor>
+   void for_each(Visitor visit) const;
+   void reserve(size_type n);
+   void clear();
+private:
+   struct Entry
+   {
+      Key key;
+      Value value;
+      template <class K, class... Args>
+      Entry(std::piecewise_construct_t, K&& k, Args&&... args)
+         : key(std::forward<K>(k)), value(std::forward<Args>(args)...) { }
+   };
+   // a slot holds the fingerprint of its key and room for an entry,
+   // which is only constructed while the slot is in use
+   struct Slot
+   {
+      uint32_t fingerprint;
+      typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type entry;
+   };
+   static const double MAX_LOAD;
+   static const double MAX_TOMBSTONES;
+   Hash hasher;
+   Eq equal;
+   Slot* slots;
+   int8_t* ctrl;          // capacity control bytes, followed by copies
+                          // of the first GROUP_WIDTH - 1
+   size_type capacity;
+   size_type used;        // # of slots in use
+   size_type tombstones;  // # of slots marked CTRL_DELETED by erase
+
+   // K is only hashed as is (rather than as a Key) by a transparent
+   // hash function
+   template <class K, class H = Hash>
+   uint32_t fingerprint(const K& key, typename H::is_transparent* = 0) const;
+   uint32_t fingerprint(const Key& key) const;
+   Entry& entry_at(size_type i);
+   const Entry& entry_at(size_type i) const;
+   void set_ctrl(size_type i, int8_t value);
+   template <class K>
+   size_type locate(const K& key, uint32_t fp, size_type& vacant) const;
+   size_type place(uint32_t fp);
+   void allocate(size_type new_capacity);
+   void resize(size_type new_capacity);
+   void destroy();
+
+   // disable copy construction & copy assignment
+   HashMap(const HashMap& src);
+   void operator=(const HashMap& rhs);
+};
+
+// the same load-factor limits as HashTable's
+template <class Key, class Value, class Hash, class Eq>
+const double HashMap<Key, Value, Hash, Eq>::MAX_LOAD = 0.45;
+template <class Key, class Value, class Hash, class Eq>
+const double HashMap<Key, Value, Hash, Eq>::MAX_TOMBSTONES = 0.10;
+
+// constructs an empty hash map with room for initial_capacity slots
+// (at least INIT_CAP)
+template <class Key, class Value, class Hash, class Eq>
+HashMap<Key, Value, Hash, Eq>::HashMap(size_type initial_capacity,
+                                       const Hash& hash, const Eq& eq)
+   : hasher(hash), equal(eq), slots(0), ctrl(0), capacity(0), used(0),
+     tombstones(0)
+{
+   allocate(next_prime(initial_capacity < INIT_CAP ? INIT_CAP
+                                                   : initial_capacity));
+}
+
+// destroys the entries and returns the slots to the heap
+template <class Key, class Value, class Hash, class Eq>
+HashMap<Key, Value, Hash, Eq>::~HashMap()
+{ destroy(); }
+
+// returns the # of slots
+template <class Key, class Value, class Hash, class Eq>
+typename HashMap<Key, Value, Hash, Eq>::size_type
+HashMap<Key, Value, Hash, Eq>::cap() const
+{ return capacity; }
+
+// returns the # of entries
+template <class Key, class Value, class Hash, class Eq>
+typename HashMap<Key, Value, Hash, Eq>::size_type
+HashMap<Key, Value, Hash, Eq>::size() const
+{ return used; }
+
+// returns true if there are no entries
+template <class Key, class Value, class Hash, class Eq>
+bool HashMap<Key, Value, Hash, Eq>::empty() const
+{ return used == 0; }
+
+// returns load-factor calculated as a fraction
+template <class Key, class Value, class Hash, class Eq>
+double HashMap<Key, Value, Hash, Eq>::load_factor() const
+{ return double(used) / capacity; }
+
+// returns the value of key, or 0 if key is not in the hash map
+template <class Key, class Value, class Hash, class Eq>
+template <class K>
+Value* HashMap<Key, Value, Hash, Eq>::find(const K& key)
+{
+   size_type vacant;
+   size_type i = locate(key, fingerprint(key), vacant);
+   return i == capacity ? 0 : &entry_at(i).value;
+}
+
+// same as above, for a constant hash map
+template <class Key, class Value, class Hash, class Eq>
+template <class K>
+const Value* HashMap<Key, Value, Hash, Eq>::find(const K& key) const
+{
+   size_type vacant;
+   size_type i = locate(key, fingerprint(key), vacant);
+   return i == capacity ? 0 : &entry_at(i).value;
+}
+
+// returns true if key is in the hash map
+template <class Key, class Value, class Hash, class Eq>
+template <class K>
+bool HashMap<Key, Value, Hash, Eq>::contains(const K& key) const
+{ return find(key) != 0; }
+
+// an entry for key, with its value constructed in place from args,
+// is added unless key is already in the hash map; returns the value
+// of key and true if the entry was added (false if it was there)
+template <class Key, class Value, class Hash, class Eq>
+template <class K, class... Args>
+std::pair<Value*, bool>
+HashMap<Key, Value, Hash, Eq>::try_emplace(K&& key, Args&&... args)
+{
+   uint32_t fp = fingerprint(key);
+   size_type vacant;
+   size_type i = locate(key, fp, vacant);
+   if (i != capacity)
+      return std::make_pair(&entry_at(i).value, false);
+   if (MAX_LOAD * capacity < used + 1)
+   {
+      resize(next_prime(2 * capacity));
+      vacant = capacity;
+   }
+   if (vacant == capacity)
+      vacant = place(fp);
+   else if (ctrl[vacant] == CTRL_DELETED)
+      tombstones--;
+   new (&slots[vacant].entry) Entry(std::piecewise_construct,
+                                    std::forward<K>(key),
+                                    std::forward<Args>(args)...);
+   slots[vacant].fingerprint = fp;
+   set_ctrl(vacant, ctrl_tag(fp));
+   used++;
+   return std::make_pair(&entry_at(vacant).value, true);
+}
+
+// an entry for key, with value value, is added unless key is already
+// in the hash map; returns true if the entry was added
+template <class Key, class Value, class Hash, class Eq>
+bool HashMap<Key, Value, Hash, Eq>::insert(Key key, Value value)
+{ return try_emplace(std::move(key), std::move(value)).second; }
+
+// returns the value of key, adding an entry for key with a default
+// value first if key is not in the hash map
+template <class Key, class Value, class Hash, class Eq>
+Value& HashMap<Key, Value, Hash, Eq>::operator[](const Key& key)
+{ return *try_emplace(key).first; }
+
+// the entry for key is removed if it is there: its slot is marked
+// deleted (a tombstone), and once tombstones take up more than
+// MAX_TOMBSTONES of the slots, the slots are rebuilt; returns true if
+// the entry was removed, otherwise returns false
+template <class Key, class Value, class Hash, class Eq>
+template <class K>
+bool HashMap<Key, Value, Hash, Eq>::erase(const K& key)
+{
+   size_type vacant;
+   size_type i = locate(key, fingerprint(key), vacant);
+   if (i == capacity)
+      return false;
+   entry_at(i).~Entry();
+   set_ctrl(i, CTRL_DELETED);
+   tombstones++;
+   used--;
+   if (MAX_TOMBSTONES * capacity < tombstones)
+      resize(capacity);
+   return true;
+}
+
+// calls visit(key, value) with each entry (in slot order)
+template <class Key, class Value, class Hash, class Eq>
+template <class Visitor>
+void HashMap<Key, Value, Hash, Eq>::for_each(Visitor visit)
+{
+   for (size_type i = 0; i < capacity; ++i)
+      if (ctrl[i] >= 0)
+         visit(const_cast<const Key&>(entry_at(i).key), entry_at(i).value);
+}
+
+// same as above, for a constant hash map
+template <class Key, class Value, class Hash, class Eq>
+template <class Visitor>
+void HashMap<Key, Value, Hash, Eq>::for_each(Visitor visit) const
+{
+   for (size_type i = 0; i < capacity; ++i)
+      if (ctrl[i] >= 0)
+         visit(entry_at(i).key, entry_at(i).value);
+}
+
+// grows the hash map (if needed) so that it can hold n entries
+// without rebuilding the slots along the way
+template <class Key, class Value, class Hash, class Eq>
+void HashMap<Key, Value, Hash, Eq>::reserve(size_type n)
+{
+   if (double(n) / capacity > MAX_LOAD)
+      resize(next_prime(size_type(n / MAX_LOAD) + 1));
+}
+
+// removes every entry (keeping the slots)
+template <class Key, class Value, class Hash, class Eq>
+void HashMap<Key, Value, Hash, Eq>::clear()
+{
+   for (size_type i = 0; i < capacity; ++i)
+      if (ctrl[i] >= 0)
+         entry_at(i).~Entry();
+   for (size_type i = 0; i < capacity + GROUP_WIDTH - 1; ++i)
+      ctrl[i] = CTRL_EMPTY;
+   used = 0;
+   tombstones = 0;
+}
+
+// returns the fingerprint of key, hashed as is
+template <class Key, class Value, class Hash, class Eq>
+template <class K, class H>
+uint32_t HashMap<Key, Value, Hash, Eq>::fingerprint(
+   const K& key, typename H::is_transparent*) const
+{
+   size_t h = hasher(key);
+   return uint32_t(h ^ (uint64_t(h) >> 32));
+}
+
+// returns the fingerprint of key
+template <class Key, class Value, class Hash, class Eq>
+uint32_t HashMap<Key, Value, Hash, Eq>::fingerprint(const Key& key) const
+{
+   size_t h = hasher(key);
+   return uint32_t(h ^ (uint64_t(h) >> 32));
+}
+
+// returns the entry in slot i (which must be in use)
+template <class Key, class Value, class Hash, class Eq>
+typename HashMap<Key, Value, Hash, Eq>::Entry&
+HashMap<Key, Value, Hash, Eq>::entry_at(size_type i)
+{ return *reinterpret_cast<Entry*>(&slots[i].entry); }
+
+template <class Key, class Value, class Hash, class Eq>
+const typename HashMap<Key, Value, Hash, Eq>::Entry&
+HashMap<Key, Value, Hash, Eq>::entry_at(size_type i) const
+{ return *reinterpret_cast<const Entry*>(&slots[i].entry); }
+
+// sets the control byte of slot i (and its copy past the end)
+template <class Key, class Value, class Hash, class Eq>
+void HashMap<Key, Value, Hash, Eq>::set_ctrl(size_type i, int8_t value)
+{
+   ctrl[i] = value;
+   if (i < GROUP_WIDTH - 1)
+      ctrl[capacity + i] = value;
+}
+
+// returns the index of the slot holding key (whose fingerprint is
+// fp) if it is there, otherwise returns capacity and sets vacant to
+// the first vacant or deleted slot of its probe sequence (or to
+// capacity if it has none); the probe sequence is HashTable's for a
+// prime capacity: the index-th group visited is GROUP_WIDTH * index
+// * index slots past the home slot
+template <class Key, class Value, class Hash, class Eq>
+template <class K>
+typename HashMap<Key, Value, Hash, Eq>::size_type
+HashMap<Key, Value, Hash, Eq>::locate(const K& key, uint32_t fp,
+                                      size_type& vacant) const
+{
+   int8_t tag = ctrl_tag(fp);
+   size_type location = fp % capacity;
+   size_type delta = GROUP_WIDTH;
+   vacant = capacity;
+   for (size_type index = 0; index < capacity; ++index)
+   {
+      CtrlGroup group(ctrl + location);
+      for (uint32_t m = group.match(tag); m != 0; m &= m - 1)
+      {
+         size_type i = location + lowest_bit(m);
+         if (i >= capacity) i -= capacity;
+         if (slots[i].fingerprint == fp && equal(entry_at(i).key, key))
+            return i;
+      }
+      uint32_t free = group.match_vacant();
+      if (vacant == capacity && free != 0)
+      {
+         vacant = location + lowest_bit(free);
+         if (vacant >= capacity) vacant -= capacity;
+      }
+      if (group.match_empty() != 0)
+         break;
+      location += delta;
+      if (location >= capacity) location -= capacity;
+      delta += 2 * GROUP_WIDTH;
+      while (delta >= capacity) delta -= capacity;
+   }
+   return capacity;
+}
+
+// returns the first vacant slot of the probe sequence of fp
+template <class Key, class Value, class Hash, class Eq>
+typename HashMap<Key, Value, Hash, Eq>::size_type
+HashMap<Key, Value, Hash, Eq>::place(uint32_t fp)
+{
+   size_type location = fp % capacity;
+   size_type delta = GROUP_WIDTH;
+   for (;;)
+   {
+      uint32_t m = CtrlGroup(ctrl + location).match_vacant();
+      if (m != 0)
+      {
+         size_type i = location + lowest_bit(m);
+         return i >= capacity ? i - capacity : i;
+      }
+      location += delta;
+      if (location >= capacity) location -= capacity;
+      delta += 2 * GROUP_WIDTH;
+      while (delta >= capacity) delta -= capacity;
+   }
+}
+
+// gives the hash map new_capacity (> GROUP_WIDTH) vacant slots
+template <class Key, class Value, class Hash, class Eq>
+void HashMap<Key, Value, Hash, Eq>::allocate(size_type new_capacity)
+{
+   slots = static_cast<Slot*>(::operator new(new_capacity * sizeof(Slot)));
+   ctrl = new int8_t[new_capacity + GROUP_WIDTH - 1];
+   capacity = new_capacity;
+   for (size_type i = 0; i < capacity + GROUP_WIDTH - 1; ++i)
+      ctrl[i] = CTRL_EMPTY;
+}
+
+// the slots are rebuilt with new_capacity slots (a prime large
+// enough for all entries), the entries being moved over (using the
+// stored fingerprints, so no key is hashed again)
+template <class Key, class Value, class Hash, class Eq>
+void HashMap<Key, Value, Hash, Eq>::resize(size_type new_capacity)
+{
+   Slot* old_slots = slots;
+   int8_t* old_ctrl = ctrl;
+   size_type old_capacity = capacity;
+   allocate(new_capacity);
+   for (size_type i = 0; i < old_capacity; ++i)
+   {
+      if (old_ctrl[i] < 0)
+         continue;
+      Entry& item = *reinterpret_cast<Entry*>(&old_slots[i].entry);
+      uint32_t fp = old_slots[i].fingerprint;
+      size_type j = place(fp);
+      new (&slots[j].entry) Entry(std::move(item));
+      slots[j].fingerprint = fp;
+      set_ctrl(j, ctrl_tag(fp));
+      item.~Entry();
+   }
+   tombstones = 0;
+   ::operator delete(old_slots);
+   delete [] old_ctrl;
+}
+
+// destroys the entries and returns the slots to the heap
+template <class Key, class Value, class Hash, class Eq>
+void HashMap<Key, Value, Hash, Eq>::destroy()
+{
+   for (size_type i = 0; i < capacity; ++i)
+      if (ctrl[i] >= 0)
+         entry_at(i).~Entry();
+   ::operator delete(slots);
+   delete [] ctrl;
+}
+
+#endif
@@ -2,41 +2,250 @@
 #include <iomanip>  // for use of setw
 #include <cstring>
 #include <cmath>
+#include <fstream>  // for use of ofstream
+#include <thread>   // for use of thread
+#include <functional> // for use of ref
+#include <chrono>   // for use of steady_clock
+#include "TextKernels.h"
 using namespace std;
 
+// the load-factor above which the hash table grows
+static const double MAX_LOAD = 0.45;
+
+// the same under Robin Hood probing, which keeps probe sequences
+// short (and their lengths even) at a much higher load-factor
+static const double ROBIN_HOOD_MAX_LOAD = 0.875;
+
+// the fraction of the slots that may hold tombstones (left by erase)
+// before the hash table is cleaned up in place; with MAX_LOAD, this
+// keeps at least 45% of the slots vacant, so probe sequences stay
+// short and always end
+static const double MAX_TOMBSTONES = 0.10;
+
+// # of old-table slots an operation moves along while an incremental
+// rehash is under way (the new table is twice as big, so anything
+// over 1 / MAX_LOAD is enough to finish before it needs to grow)
+static const HashTable::size_type MIGRATE_STEP = 32;
+
+// # of words search_batch hashes (and prefetches the slots of) ahead
+// of resolving them
+static const HashTable::size_type BATCH_CHUNK = 16;
+
+// layout of the header of a hash-table image (see save_image), with
+// every field in the byte order of the machine that wrote the image
+struct ImageHeader
+{
+   char magic[8];         // IMAGE_MAGIC
+   uint32_t version;      // IMAGE_VERSION
+   uint32_t group_width;  // GROUP_WIDTH the control bytes are for
+   uint32_t sizing;       // sizing_policy the slots were placed under
+   uint32_t hasher;       // hash_policy the fingerprints came from
+   uint32_t probing;      // probing_policy the slots were placed under
+   uint32_t reserved;     // 0 (keeps the 64-bit fields aligned)
+   uint64_t capacity;
+   uint64_t used;
+   uint64_t tombstones;   // # of slots marked deleted by erase
+   uint64_t ctrl_offset;  // file offset of the control bytes
+   uint64_t slot_offset;  // file offset of the slots
+   uint64_t count_offset; // file offset of the counts (0 if none)
+   uint64_t word_offset;  // file offset of the (null-terminated) words
+   uint64_t file_size;
+};
+static const char IMAGE_MAGIC[8] = "HTIMAGE";
+static const uint32_t IMAGE_VERSION = 6;
+
 // a new hash table whose capacity is the prime number closest to
 // and greater that 2 times the capacity of the old hash table
 // replaces the old hash table and all items from the old hash table
 // are rehashed (re-inserted) into the new hash table
 // (the old hash table is discarded - memory returned to heap)
 // (HINT: put next_prime and insert to good use)
+// with incremental_rehash, the old hash table is kept instead and
+// its items are moved over a few at a time by later operations
+// (see migrate)
 void HashTable::rehash()
 {
-   Item* temp_data = data;
-   size_type temp_capacity = capacity;
+   if( ! opts.incremental_rehash ){
+       resize(allowed_capacity(2 * table.capacity));
+       return;
+   }
+   chrono::steady_clock::time_point beg = chrono::steady_clock::now();
+   finish_rehash();
+   old_table = table;
+   old_used = used;
+   migrated = 0;
+   allocate(table, allowed_capacity(2 * table.capacity), counted);
+   tombstones = 0;
+   long_probe = false;
+   // filter keeps serving searches (it has every item); the filter
+   // for table is only allocated here and filled as items migrate,
+   // so no single operation walks all the slots
+   if(opts.bloom_bits != 0)
+       next_filter.reset(size_type(max_load() * table.capacity) + 1,
+                         opts.bloom_bits);
+   count_rehash(beg);
+}
+
+// the hash table is rebuilt with new_capacity (assumed allowed by the
+// sizing policy and large enough for all items) slots, all at once;
+// see rehash above
+void HashTable::resize(size_type new_capacity)
+{
+   chrono::steady_clock::time_point beg = chrono::steady_clock::now();
+   finish_rehash();
+   Table temp = table;
+   allocate(table, new_capacity, counted);
+   long_probe = false;
 
-   capacity = next_prime(2 * capacity);
-   used = 0;
+   // the words stay where they are in the arena, only their slots
+   // are re-placed (using the stored fingerprints, so no word needs
+   // to be hashed again)
+   for(size_type i = 0; i < temp.capacity; i++){
+       if(in_use(temp, i))
+           place(table, temp.data[i], count_at(temp, i));
+   }
 
-   data = new Item[capacity];
+   release(temp);
+   tombstones = 0;
+   build_filter();
+   count_rehash(beg);
+}
 
-   for(size_type i = 0; i < capacity; i++)
-       strcpy(data[i].word, "");
+// the tombstones left by erase are cleared from the hash table in
+// place (no new table is allocated): every item is marked as pending,
+// every tombstone as vacant, and then each pending item is moved to
+// the first slot of its probe sequence that is not taken by an item
+// already settled, swapping with a pending item found there, unless
+// its own slot lies in the same group as that one
+void HashTable::drop_tombstones()
+{
+   finish_rehash();
+   for(size_type i = 0; i < table.capacity; i++)
+       set_ctrl(table, i, in_use(table, i) ? CTRL_DELETED : CTRL_EMPTY);
 
-   for(size_type i = 0; i < temp_capacity; i++){
-       if(temp_data[i].word[0] != '\0')
-           insert(temp_data[i].word);
+   for(size_type i = 0; i < table.capacity; i++){
+       if(table.ctrl[i] != CTRL_DELETED)
+           continue;
+       uint32_t fingerprint = table.data[i].fingerprint;
+       Probe p = probe_start(table, fingerprint);
+       uint32_t m;
+       while((m = CtrlGroup(table.ctrl + p.location).match_vacant()) == 0)
+           probe_next(table, p);
+       size_type target = slot_index(table, p.location, lowest_bit(m));
+       if((i + table.capacity - p.location) % table.capacity < GROUP_WIDTH){
+           set_ctrl(table, i, ctrl_tag(fingerprint));
+           continue;
+       }
+       if(table.ctrl[target] == CTRL_EMPTY){
+           table.data[target] = table.data[i];
+           set_count(table, target, count_at(table, i));
+           set_ctrl(table, target, ctrl_tag(fingerprint));
+           set_ctrl(table, i, CTRL_EMPTY);
+       }
+       else{
+           // target holds a pending item, which takes i's place and is
+           // dealt with next
+           Slot temp = table.data[target];
+           uint32_t temp_count = count_at(table, target);
+           table.data[target] = table.data[i];
+           set_count(table, target, count_at(table, i));
+           table.data[i] = temp;
+           set_count(table, i, temp_count);
+           set_ctrl(table, target, ctrl_tag(fingerprint));
+           i--;
+       }
    }
-   
-   delete temp_data;
+   tombstones = 0;
+   build_filter();
+   if(opts.collect_stats)
+       counters.cleanups++;
+}
+
+// (with bloom_bits) the Bloom filter is sized for as many words as
+// the slots can hold before the hash table grows, and the fingerprints
+// of the items in table (and old_table) are added to it, leaving out
+// the words erased since it was last built (any filter an incremental
+// rehash was filling is dropped); walks every slot, so it is left to
+// the operations that do so anyway (an incremental rehash fills its
+// filter as it goes instead)
+void HashTable::build_filter()
+{
+   next_filter.release();
+   if(opts.bloom_bits == 0)
+       return;
+   filter.reset(size_type(max_load() * table.capacity) + 1, opts.bloom_bits);
+   for(size_type i = 0; i < table.capacity; i++)
+       if(in_use(table, i))
+           filter.add(table.data[i].fingerprint);
+   for(size_type i = 0; old_table.data != 0 && i < old_table.capacity; i++)
+       if(in_use(old_table, i))
+           filter.add(old_table.data[i].fingerprint);
+}
+
+// (with bloom_bits) adds a new item's fingerprint to the Bloom filter,
+// and to the one an incremental rehash under way is filling
+void HashTable::add_to_filter(uint32_t fingerprint)
+{
+   if(opts.bloom_bits == 0)
+       return;
+   filter.add(fingerprint);
+   if(old_table.data != 0)
+       next_filter.add(fingerprint);
+}
+
+// cleans up the tombstones if there are too many of them
+void HashTable::check_tombstones()
+{
+   if(MAX_TOMBSTONES * table.capacity < tombstones)
+       drop_tombstones();
+}
+
+// the items in the next (up to) steps slots of old_table are moved
+// to table; old_table is discarded once it has been emptied
+void HashTable::migrate(size_type steps) const
+{
+   if(old_table.data == 0)
+       return;
+   size_type stop = migrated + steps;
+   if(stop > old_table.capacity)
+       stop = old_table.capacity;
+   for(; migrated < stop && old_used > 0; migrated++){
+       if(in_use(old_table, migrated)){
+           place(table, old_table.data[migrated],
+                 count_at(old_table, migrated));
+           if(opts.bloom_bits != 0)
+               next_filter.add(old_table.data[migrated].fingerprint);
+           set_ctrl(old_table, migrated, CTRL_DELETED);
+           old_used--;
+       }
+   }
+   if(old_used == 0){
+       release(old_table);
+       if(opts.bloom_bits != 0){
+           filter.swap(next_filter);
+           next_filter.release();
+       }
+   }
+}
+
+// completes an incremental rehash (if one is under way)
+void HashTable::finish_rehash() const
+{
+   if(old_table.data != 0)
+       migrate(old_table.capacity);
 }
 
 // returns true if cStr already exists in the hash table,
 // otherwise returns false
 bool HashTable::exists(const char* cStr) const
 {
-   for (size_type i = 0; i < capacity; ++i)
-      if ( ! strcmp(data[i].word, cStr) ) return true;
+   size_type len = strlen(cStr);
+   for (size_type i = 0; i < table.capacity; ++i)
+      if ( in_use(table, i) && same_word(table.data[i], cStr, len) )
+         return true;
+   for (size_type i = 0; old_table.data != 0 && i < old_table.capacity; ++i)
+      if ( in_use(old_table, i) && same_word(old_table.data[i], cStr, len) )
+         return true;
    return false;
 }
 
@@ -45,75 +254,843 @@ bool HashTable::exists(const char* cStr) const
 // like what is done in exists above),
 // otherwise return false
 // CAUTION: major penalty if not using hashing technique
+// (probing visits groups of GROUP_WIDTH slots, quadratically
+// spaced; within a group only the slots whose control-byte tag
+// matches are looked at, and a group with a vacant slot in it
+// ends the probe sequence)
 bool HashTable::search(const char* cStr) const
 {
-   size_type startLocation, location, index = 0;
-   startLocation = hash(cStr);
-   location = startLocation;
+   migrate(MIGRATE_STEP);
+   begin_op();
+   size_type len = strlen(cStr);
+   bool found = lookup(cStr, len, hash(cStr, len));
+   end_op(SEARCH_OP);
+   return found;
+}
 
-   while(index < capacity){
-      if ( ! strcmp(data[location].word, cStr) ) return true;
-       else{
-           index++;
-           location = ((startLocation + (index * index)) % capacity);
+// returns true if the len-character word, whose hash value (as
+// hash_word gives it for hasher()) is fingerprint, can be found in
+// the hash table, otherwise returns false; for callers that work the
+// hash value out more cheaply than hashing the word from scratch
+// (if count is not 0 and the word is found, *count is set to its
+// count, see count below, in the same probe)
+bool HashTable::search_hashed(const char* word, size_type len,
+                              uint32_t fingerprint, uint32_t* count) const
+{
+   migrate(MIGRATE_STEP);
+   begin_op();
+   bool found = lookup(word, len, fingerprint, count);
+   end_op(SEARCH_OP);
+   return found;
+}
+
+// out[i] is set to search(words[i]) for each of the n words, but with
+// the work done in chunks: every word of a chunk is hashed and the
+// control bytes and slots of its home group prefetched before any of
+// them is looked up, so the cache misses of the chunk overlap rather
+// than being taken one after the other
+void HashTable::search_batch(const char* const* words, size_type n,
+                             bool* out) const
+{
+   migrate(MIGRATE_STEP);
+   size_type lens[BATCH_CHUNK];
+   uint32_t fingerprints[BATCH_CHUNK];
+   for(size_type beg = 0; beg < n; beg += BATCH_CHUNK){
+       size_type count = (n - beg < BATCH_CHUNK) ? n - beg : BATCH_CHUNK;
+       for(size_type k = 0; k < count; ++k){
+           lens[k] = strlen(words[beg + k]);
+           fingerprints[k] = hash(words[beg + k], lens[k]);
+           Probe p = probe_start(table, fingerprints[k]);
+           __builtin_prefetch(table.ctrl + p.location);
+           __builtin_prefetch(table.data + p.location);
+           if(old_table.data != 0){
+               p = probe_start(old_table, fingerprints[k]);
+               __builtin_prefetch(old_table.ctrl + p.location);
+               __builtin_prefetch(old_table.data + p.location);
+           }
+       }
+       for(size_type k = 0; k < count; ++k){
+           begin_op();
+           out[beg + k] = lookup(words[beg + k], lens[k], fingerprints[k]);
+           end_op(SEARCH_OP);
        }
    }
+}
 
-   return false;
+// returns true if the len-character word (whose hash value is
+// fingerprint) is in table or, during an incremental rehash, in
+// old_table, setting *count (if count is not 0) to its count,
+// otherwise returns false (without probing, if the Bloom filter
+// turns the word away)
+bool HashTable::lookup(const char* word, size_type len,
+                       uint32_t fingerprint, uint32_t* count) const
+{
+   if(opts.bloom_bits != 0 && ! filter.may_contain(fingerprint)){
+       if(opts.collect_stats)
+           counters.bloom_rejects++;
+       return false;
+   }
+   size_type vacant;
+   const Table* t = &table;
+   size_type i = find(table, word, len, fingerprint, vacant);
+   if(i == table.capacity){
+       if(old_table.data != 0){
+           t = &old_table;
+           i = find(old_table, word, len, fingerprint, vacant);
+       }
+       if(i == t->capacity){
+           if(opts.bloom_bits != 0 && opts.collect_stats)
+               counters.bloom_false_positives++;
+           return false;
+       }
+   }
+   if(count != 0)
+       *count = count_at(*t, i);
+   return true;
+}
+
+// returns the index of the slot of t holding the len-character word
+// (whose hash value is fingerprint) if it is there, otherwise returns
+// t.capacity and sets vacant to the slot where the word would be
+// inserted, the first vacant or deleted slot of its probe sequence
+// (or to t.capacity if the probe sequence has no vacant slot, or
+// under Robin Hood probing, where place decides)
+HashTable::size_type HashTable::find(const Table& t, const char* word,
+                                     size_type len, uint32_t fingerprint,
+                                     size_type& vacant) const
+{
+   if(opts.probing == ROBIN_HOOD_PROBING){
+       vacant = t.capacity;
+       return rh_find(t, word, len, fingerprint);
+   }
+   int8_t tag = ctrl_tag(fingerprint);
+   Probe p = probe_start(t, fingerprint);
+   vacant = t.capacity;
+
+   while(p.index < t.capacity){
+       CtrlGroup group(t.ctrl + p.location);
+       for(uint32_t m = group.match(tag); m != 0; m &= m - 1){
+           size_type i = slot_index(t, p.location, lowest_bit(m));
+           if(t.data[i].fingerprint == fingerprint &&
+              same_word(t.data[i], word, len) ){
+               count_probes(p.index + 1);
+               return i;
+           }
+       }
+       uint32_t free = group.match_vacant();
+       if(vacant == t.capacity && free != 0)
+           vacant = slot_index(t, p.location, lowest_bit(free));
+       if(group.match_empty() != 0)
+           break;
+       probe_next(t, p);
+   }
+
+   count_probes(p.index + 1);
+   return t.capacity;
+}
+
+// find under Robin Hood probing: the slots from the home slot on are
+// looked at one by one, and the search ends early at a slot whose
+// item lies closer to its own home than the word would (Robin Hood
+// placement would have put the word there, ahead of that item)
+// (slots marked deleted, which only old_table has, are passed over)
+HashTable::size_type HashTable::rh_find(const Table& t, const char* word,
+                                        size_type len,
+                                        uint32_t fingerprint) const
+{
+   size_type i = probe_start(t, fingerprint).location;
+   for(int distance = 0; ; ++distance){
+       int8_t c = t.ctrl[i];
+       if(c == CTRL_EMPTY ||
+          (c >= 0 && c < (distance < MAX_DISTANCE ? distance : MAX_DISTANCE))){
+           count_probes(distance + 1);
+           return t.capacity;
+       }
+       if(c >= 0 && t.data[i].fingerprint == fingerprint &&
+          same_word(t.data[i], word, len)){
+           count_probes(distance + 1);
+           return i;
+       }
+       if(++i == t.capacity) i = 0;
+   }
+}
+
+// place under Robin Hood probing: item takes the first slot, from
+// its home slot on, that is vacant or whose item lies closer to its
+// own home, and the item displaced from there moves on in the same
+// way; returns the index of the slot item went into
+// (distances that saturate the control byte are worked out from the
+// fingerprints, so that the order is kept exactly)
+HashTable::size_type HashTable::rh_place(const Table& t, const Slot& item,
+                                         uint32_t count) const
+{
+   Slot carried = item;
+   uint32_t carried_count = count;
+   size_type i = probe_start(t, item.fingerprint).location;
+   size_type placed = t.capacity;
+   for(size_type distance = 0, probes = 1; ; ++distance, ++probes){
+       int8_t d = int8_t(distance < size_type(MAX_DISTANCE) ? distance
+                                                            : MAX_DISTANCE);
+       if(d == MAX_DISTANCE)
+           long_probe = true;
+       int8_t c = t.ctrl[i];
+       size_type resident = size_type(c);
+       if(c == MAX_DISTANCE && d == MAX_DISTANCE)
+           resident = rh_distance(t, t.data[i].fingerprint, i);
+       if(c < d || (c == MAX_DISTANCE && resident < distance)){
+           if(placed == t.capacity)
+               placed = i;
+           Slot temp = t.data[i];
+           uint32_t temp_count = count_at(t, i);
+           t.data[i] = carried;
+           set_count(t, i, carried_count);
+           set_ctrl(t, i, d);
+           if(c < 0){
+               count_probes(probes);
+               return placed;
+           }
+           carried = temp;
+           carried_count = temp_count;
+           distance = resident;
+       }
+       if(++i == t.capacity) i = 0;
+   }
+}
+
+// the item in slot i of t is removed by shifting the items after it
+// back one slot each, up to the first that is vacant or at its home
+// slot (backward-shift deletion, so no tombstone is left behind)
+void HashTable::rh_remove(const Table& t, size_type i) const
+{
+   size_type j = (i + 1 == t.capacity) ? 0 : i + 1;
+   while(t.ctrl[j] > 0){
+       t.data[i] = t.data[j];
+       set_count(t, i, count_at(t, j));
+       size_type distance = (t.ctrl[j] == MAX_DISTANCE)
+                            ? rh_distance(t, t.data[i].fingerprint, i)
+                            : size_type(t.ctrl[j] - 1);
+       set_ctrl(t, i, int8_t(distance < size_type(MAX_DISTANCE)
+                             ? distance : MAX_DISTANCE));
+       i = j;
+       if(++j == t.capacity) j = 0;
+   }
+   set_ctrl(t, i, CTRL_EMPTY);
 }
 
+// returns how many slots slot i of t is past the home slot of
+// fingerprint
+HashTable::size_type HashTable::rh_distance(const Table& t,
+                                            uint32_t fingerprint,
+                                            size_type i)
+{ return (i + t.capacity - probe_start(t, fingerprint).location) % t.capacity; }
+
 // returns load-factor calculated as a fraction
 double HashTable::load_factor() const
-{ return double(used) / capacity; }
+{ return double(used) / table.capacity; }
+
+// returns the count of cStr (from the count column of the dictionary
+// file it was loaded from, see load_mapped), or 0 if cStr is not in
+// the hash table or has no count
+uint32_t HashTable::count(const char* cStr) const
+{
+   size_type len = strlen(cStr);
+   uint32_t n = 0;
+   search_hashed(cStr, len, hash(cStr, len), &n);
+   return n;
+}
+
+// returns true if the hash table keeps a count for each word
+bool HashTable::has_counts() const
+{ return counted; }
+
+// returns the count of the item in slot i of t (0 if t keeps none)
+uint32_t HashTable::count_at(const Table& t, size_type i)
+{ return t.counts != 0 ? t.counts[i] : 0; }
+
+// sets the count of the item in slot i of t (if t keeps counts)
+void HashTable::set_count(const Table& t, size_type i, uint32_t count)
+{
+   if (t.counts != 0)
+      t.counts[i] = count;
+}
+
+// adds count to the count of the item in slot i of t (if t keeps
+// counts), stopping at UINT32_MAX
+void HashTable::add_count(const Table& t, size_type i, uint32_t count)
+{
+   if (t.counts != 0)
+      t.counts[i] = (t.counts[i] > UINT32_MAX - count) ? UINT32_MAX
+                                                        : t.counts[i] + count;
+}
+
+// makes the hash table keep a count for each word (0 for those
+// already in it), rebuilding its slots with room for the counts
+void HashTable::keep_counts()
+{
+   if (counted)
+      return;
+   counted = true;
+   resize(table.capacity);
+}
+
+// returns hash value computed using the hash function selected by
+// the hasher option (see hash_word)
+// the full (unreduced) value is returned since it doubles as the
+// slot fingerprint; callers reduce it to a slot index themselves
+uint32_t HashTable::hash(const char* word, size_type len) const
+{ return hash_word(opts.hasher, word, len); }
+
+// returns the average # of groups (under Robin Hood probing, slots)
+// a search probes to find an item, taken over all items in the hash
+// table
+double HashTable::avg_probe_length() const
+{
+   finish_rehash();
+   if (used == 0) return 0;
+   size_type total = 0;
+   for (size_type i = 0; i < table.capacity; ++i)
+      if ( in_use(table, i) )
+         total += probe_length(table, i);
+   return double(total) / used;
+}
+
+// returns the # of groups (under Robin Hood probing, slots) a search
+// probes to find the item in slot i of t
+HashTable::size_type HashTable::probe_length(const Table& t, size_type i) const
+{
+   if (opts.probing == ROBIN_HOOD_PROBING)
+      return rh_distance(t, t.data[i].fingerprint, i) + 1;
+   Probe p = probe_start(t, t.data[i].fingerprint);
+   while ((i + t.capacity - p.location) % t.capacity >= GROUP_WIDTH)
+      probe_next(t, p);
+   return p.index + 1;
+}
+
+// returns the counters kept with collect_stats (all 0 without it),
+// along with the longest probe to an item now in the hash table and
+// the heap memory it now takes up (which are worked out, from every
+// slot, whether or not collect_stats is on)
+HashTable::Stats HashTable::stats() const
+{
+   finish_rehash();
+   Stats result = counters;
+   result.max_displacement = 0;
+   for (size_type i = 0; i < table.capacity; ++i)
+   {
+      if ( ! in_use(table, i) ) continue;
+      size_type displacement = probe_length(table, i) - 1;
+      if (displacement > result.max_displacement)
+         result.max_displacement = displacement;
+   }
+   result.bytes_allocated = arena_cap;
+   if (table.owned)
+      result.bytes_allocated += table.capacity * sizeof(Slot)
+                                + table.capacity + GROUP_WIDTH - 1
+                                + (counted ? table.capacity * sizeof(uint32_t) : 0);
+   result.bytes_allocated += filter.memory_used() + next_filter.memory_used();
+   return result;
+}
+
+// returns the # of heap bytes the Bloom filter takes up, with the one
+// an incremental rehash under way is filling (0 without bloom_bits)
+HashTable::size_type HashTable::bloom_bytes() const
+{ return filter.memory_used() + next_filter.memory_used(); }
+
+// returns the probability that the Bloom filter lets through a word
+// not in the hash table, as worked out from its size and the # of
+// words added to it (1 without bloom_bits, every word being let
+// through); Stats counts how often it actually did
+double HashTable::bloom_fp_rate() const
+{ return opts.bloom_bits == 0 ? 1 : filter.false_positive_rate(); }
+
+// sets the counters kept with collect_stats back to 0
+void HashTable::reset_stats()
+{ counters = Stats(); }
+
+// writes stats() to out as a JSON object (with no newline after it),
+// along with the options and the size, load-factor and average probe
+// length of the hash table
+void HashTable::dump_stats(ostream& out) const
+{
+   static const char* hash_names[] = { "djb2", "fnv1a", "wyhash" };
+   Stats s = stats();
+   out << "{\n"
+       << "  \"hasher\": \"" << hash_names[opts.hasher] << "\",\n"
+       << "  \"sizing\": \""
+       << (opts.sizing == PRIME_SIZING ? "prime" : "power_of_two") << "\",\n"
+       << "  \"probing\": \""
+       << (opts.probing == ROBIN_HOOD_PROBING ? "robin_hood" : "quadratic")
+       << "\",\n"
+       << "  \"capacity\": " << table.capacity << ",\n"
+       << "  \"size\": " << used << ",\n"
+       << "  \"tombstones\": " << tombstones << ",\n"
+       << "  \"load_factor\": " << load_factor() << ",\n"
+       << "  \"max_load\": " << max_load() << ",\n"
+       << "  \"avg_probe_length\": " << avg_probe_length() << ",\n"
+       << "  \"max_displacement\": " << s.max_displacement << ",\n"
+       << "  \"bytes_allocated\": " << s.bytes_allocated << ",\n"
+       << "  \"searches\": " << s.searches << ",\n"
+       << "  \"search_probes\": " << s.search_probes << ",\n"
+       << "  \"inserts\": " << s.inserts << ",\n"
+       << "  \"insert_probes\": " << s.insert_probes << ",\n"
+       << "  \"erases\": " << s.erases << ",\n"
+       << "  \"erase_probes\": " << s.erase_probes << ",\n"
+       << "  \"max_probe\": " << s.max_probe << ",\n"
+       << "  \"probe_histogram\": [";
+   for (size_type k = 0; k < PROBE_BUCKETS; ++k)
+      out << (k > 0 ? ", " : "") << s.probe_histogram[k];
+   out << "],\n"
+       << "  \"rehashes\": " << s.rehashes << ",\n"
+       << "  \"rehash_seconds\": " << s.rehash_seconds << ",\n"
+       << "  \"cleanups\": " << s.cleanups << ",\n"
+       << "  \"bloom_bits\": " << opts.bloom_bits << ",\n"
+       << "  \"bloom_bytes\": " << bloom_bytes() << ",\n"
+       << "  \"bloom_fp_rate\": " << bloom_fp_rate() << ",\n"
+       << "  \"bloom_rejects\": " << s.bloom_rejects << ",\n"
+       << "  \"bloom_false_positives\": " << s.bloom_false_positives << "\n"
+       << "}";
+}
+
+// adds probes to the probe length of the operation under way (with
+// collect_stats)
+void HashTable::count_probes(size_type probes) const
+{
+   if (opts.collect_stats)
+      op_probes += probes;
+}
+
+// starts an operation Stats counts (after its share of an incremental
+// rehash, whose probes are not the operation's own); without
+// collect_stats it writes nothing, so that threads may search at once
+void HashTable::begin_op() const
+{
+   if (opts.collect_stats)
+      op_probes = 0;
+}
+
+// counts the operation under way, of the given kind, in the Stats
+// (with collect_stats); called before any rehash it sets off
+void HashTable::end_op(op_kind kind) const
+{
+   if ( ! opts.collect_stats )
+      return;
+   switch (kind)
+   {
+   case SEARCH_OP: counters.searches++; counters.search_probes += op_probes; break;
+   case INSERT_OP: counters.inserts++;  counters.insert_probes += op_probes; break;
+   case ERASE_OP:  counters.erases++;   counters.erase_probes += op_probes;  break;
+   }
+   size_type bucket = op_probes < PROBE_BUCKETS ? op_probes : PROBE_BUCKETS;
+   counters.probe_histogram[bucket > 0 ? bucket - 1 : 0]++;
+   if (op_probes > counters.max_probe)
+      counters.max_probe = op_probes;
+}
+
+// counts a rehash (or resize) begun at beg in the Stats (with
+// collect_stats); under incremental_rehash, only the allocation of
+// the new table is timed, not the migration that follows
+void HashTable::count_rehash(chrono::steady_clock::time_point beg) const
+{
+   if ( ! opts.collect_stats )
+      return;
+   counters.rehashes++;
+   counters.rehash_seconds +=
+      chrono::duration<double>(chrono::steady_clock::now() - beg).count();
+}
+
+// the pieces of a wyhash-style (github.com/wangyi-fudan/wyhash) hash
+__extension__ typedef unsigned __int128 wy_uint128;
+static const uint64_t WY_P0 = 0xA0761D6478BD642Full,
+                      WY_P1 = 0xE7037ED1A0B428DBull;
+
+// returns the high 64 bits xor-ed with the low 64 bits of a * b
+static uint64_t wy_mum(uint64_t a, uint64_t b)
+{
+   wy_uint128 r = wy_uint128(a) * b;
+   return uint64_t(r) ^ uint64_t(r >> 64);
+}
+
+// returns the (little-endian) 8-, 4- and 1-to-3-byte values at p
+static uint64_t wy_r8(const unsigned char* p)
+{ uint64_t v; memcpy(&v, p, 8); return v; }
+static uint64_t wy_r4(const unsigned char* p)
+{ uint32_t v; memcpy(&v, p, 4); return v; }
+static uint64_t wy_r3(const unsigned char* p, size_t k)
+{ return (uint64_t(p[0]) << 16) | (uint64_t(p[k >> 1]) << 8) | p[k - 1]; }
+
+// returns the (64-bit) wyhash-style hash value of the len bytes at p
+// under seed
+static uint64_t wy_hash(const unsigned char* p, size_t len, uint64_t seed)
+{
+   uint64_t a, b;
+   if (len <= 16)
+   {
+      if (len >= 4)
+      {
+         size_t k = (len >> 3) << 2;
+         a = (wy_r4(p) << 32) | wy_r4(p + k);
+         b = (wy_r4(p + len - 4) << 32) | wy_r4(p + len - 4 - k);
+      }
+      else if (len > 0)
+      {
+         a = wy_r3(p, len);
+         b = 0;
+      }
+      else
+         a = b = 0;
+   }
+   else
+   {
+      size_t i = len;
+      for (; i > 16; i -= 16, p += 16)
+         seed = wy_mum(wy_r8(p) ^ WY_P1, wy_r8(p + 8) ^ seed);
+      a = wy_r8(p + i - 16);
+      b = wy_r8(p + i - 8);
+   }
+   return wy_mum(WY_P1 ^ len, wy_mum(a ^ WY_P1, b ^ seed));
+}
+
+// returns true if c ends a word in the mapped dictionary file
+static bool is_delim(char c)
+{ return c == ' ' || (c >= '\t' && c <= '\r') || c == '\0'; }
+
+// # of bytes of a dictionary file scan_words splits into words at once
+static const size_t SCAN_BLOCK = 1 << 16;
+
+// calls visit(word, len) for each whitespace-separated word that
+// starts in [beg, stop) of a text ending at end (a word starting
+// before stop may run on past it); the text is split into words a
+// block at a time by find_tokens (see TextKernels.h)
+template <class Visitor>
+static void scan_words(const char* beg, const char* stop, const char* end,
+                       Visitor visit)
+{
+   vector<WordSpan> spans;
+   while(beg < stop){
+       const char* block_end = (stop - beg > ptrdiff_t(SCAN_BLOCK))
+                               ? beg + SCAN_BLOCK : stop;
+       spans.clear();
+       find_tokens(beg, block_end - beg, spans);
+       const char* next = block_end;
+       for(size_t s = 0; s < spans.size(); ++s){
+           const char* word = beg + spans[s].start;
+           size_t len = spans[s].length;
+           if(word + len == block_end){
+               while(word + len < end && ! is_delim(word[len])) ++len;
+               next = word + len;
+           }
+           visit(word, len);
+       }
+       beg = next;
+   }
+}
+
+// returns true if the len-character token is a count (all digits)
+static bool is_count(const char* token, size_t len)
+{
+   for(size_t k = 0; k < len; ++k)
+       if(token[k] < '0' || token[k] > '9')
+           return false;
+   return len > 0;
+}
+
+// returns the value of the len-digit count token (at most UINT32_MAX)
+static uint32_t parse_count(const char* token, size_t len)
+{
+   uint64_t value = 0;
+   for(size_t k = 0; k < len && value <= UINT32_MAX; ++k)
+       value = value * 10 + uint64_t(token[k] - '0');
+   return value > UINT32_MAX ? UINT32_MAX : uint32_t(value);
+}
+
+// returns true if the text [beg, end) is a dictionary file with a
+// count column: its first line is a word followed by a count
+static bool has_count_column(const char* beg, const char* end)
+{
+   const char* eol = beg;
+   while(eol < end && *eol != '\n') ++eol;
+   const char* tokens[3];
+   size_t lens[3];
+   int n = 0;
+   for(const char* p = beg; p < eol && n < 3; ){
+       while(p < eol && is_delim(*p)) ++p;
+       if(p == eol) break;
+       tokens[n] = p;
+       while(p < eol && ! is_delim(*p)) ++p;
+       lens[n] = p - tokens[n];
+       n++;
+   }
+   return n == 2 && ! is_count(tokens[0], lens[0]) && is_count(tokens[1], lens[1]);
+}
+
+// returns the word held by item
+const char* HashTable::word_at(const Slot& item) const
+{
+   if(item.offset & MAPPED_WORD)
+      return dict_file.data() + (item.offset & ~MAPPED_WORD);
+   return arena + item.offset;
+}
+
+// returns the # of characters in the word held by item
+HashTable::size_type HashTable::word_length(const Slot& item) const
+{
+   const char* word = word_at(item);
+   size_type len = 0;
+   while( ! is_delim(word[len]) ) ++len;
+   return len;
+}
+
+// returns true if the word held by item is the same as the len
+// characters starting at word
+bool HashTable::same_word(const Slot& item, const char* word,
+                          size_type len) const
+{
+   const char* stored = word_at(item);
+   if( ! (item.offset & MAPPED_WORD) )
+      return ! strncmp(stored, word, len) && stored[len] == '\0';
+   for(size_type k = 0; k < len; ++k)
+      if(stored[k] != word[k] || is_delim(stored[k]))
+         return false;
+   return is_delim(stored[len]);
+}
+
+// returns true if slot i of t holds an item
+bool HashTable::in_use(const Table& t, size_type i)
+{ return t.ctrl[i] >= 0; }
+
+// sets the control byte of slot i of t, along with its copy past the
+// end of the control array if i is one of the first GROUP_WIDTH - 1
+void HashTable::set_ctrl(const Table& t, size_type i, int8_t value)
+{
+   t.ctrl[i] = value;
+   for (size_type j = i + t.capacity; j < t.capacity + GROUP_WIDTH - 1; j += t.capacity)
+      t.ctrl[j] = value;
+}
 
-// returns hash value computed using the djb2 hash algorithm
-// (2nd page of Lecture Note 324s02AdditionalNotesOnHashFunctions)
-HashTable::size_type HashTable::hash(const char* word) const
+// returns the index of the slot of t k places into the group at pos
+HashTable::size_type HashTable::slot_index(const Table& t, size_type pos,
+                                           unsigned k)
 {
-   unsigned long hash = 5381;
-   int c;
-   while((c = *word++)) hash = ((hash << 5) + hash) + c; //hash * 33 + c
-   return (hash % capacity);
+   size_type i = pos + k;
+   if (i < t.capacity) return i;
+   return t.mask ? (i & t.mask) : i % t.capacity;
+}
+
+// returns a hash value with its bits thoroughly mixed (the murmur3
+// finalizer), so that its low bits alone make a good slot index
+static uint32_t mix(uint32_t h)
+{
+   h ^= h >> 16;
+   h *= 0x85EBCA6Bu;
+   h ^= h >> 13;
+   h *= 0xC2B2AE35u;
+   h ^= h >> 16;
+   return h;
+}
+
+// returns the start of the probe sequence of fingerprint in t: its
+// home slot is fingerprint modulo a prime capacity, or the mixed
+// fingerprint masked to a power-of-two capacity
+HashTable::Probe HashTable::probe_start(const Table& t, uint32_t fingerprint)
+{
+   Probe p;
+   p.index = 0;
+   if (t.mask)
+   {
+      p.location = mix(fingerprint) & t.mask;
+      p.delta = GROUP_WIDTH;
+   }
+   else
+   {
+      p.location = fingerprint % t.capacity;
+      p.delta = GROUP_WIDTH % t.capacity;
+   }
+   return p;
+}
+
+// moves p on to the next group of the probe sequence: the index-th
+// group is GROUP_WIDTH * index * index slots past the home slot for
+// a prime capacity (kept up to date without a modulo per step), and
+// GROUP_WIDTH * index * (index + 1) / 2 slots past it for a power-of-
+// two capacity (which visits every group position)
+void HashTable::probe_next(const Table& t, Probe& p)
+{
+   p.index++;
+   if (t.mask)
+   {
+      p.location = (p.location + p.delta) & t.mask;
+      p.delta += GROUP_WIDTH;
+   }
+   else
+   {
+      p.location += p.delta;
+      if (p.location >= t.capacity) p.location -= t.capacity;
+      p.delta += 2 * GROUP_WIDTH;
+      while (p.delta >= t.capacity) p.delta -= t.capacity;
+   }
+}
+
+// returns the capacity the sizing policy gives a hash table that
+// needs at least n slots (the smallest prime, or power of two, >= n)
+HashTable::size_type HashTable::allowed_capacity(size_type n) const
+{
+   if (opts.sizing == PRIME_SIZING)
+      return next_prime(n);
+   size_type capacity = GROUP_WIDTH;
+   while (capacity < n) capacity *= 2;
+   return capacity;
+}
+
+// returns the load-factor above which the hash table grows
+double HashTable::max_load() const
+{ return opts.probing == ROBIN_HOOD_PROBING ? ROBIN_HOOD_MAX_LOAD : MAX_LOAD; }
+
+// gives t new (heap) arrays for capacity slots, all vacant (with an
+// array of counts, all 0, if with_counts is true)
+void HashTable::allocate(Table& t, size_type capacity, bool with_counts)
+{
+   t.data = new Slot[capacity];
+   t.ctrl = new int8_t[capacity + GROUP_WIDTH - 1];
+   t.counts = with_counts ? new uint32_t[capacity]() : 0;
+   t.capacity = capacity;
+   t.mask = (capacity & (capacity - 1)) == 0 ? capacity - 1 : 0;
+   t.owned = true;
+   for (size_type i = 0; i < capacity + GROUP_WIDTH - 1; ++i)
+      t.ctrl[i] = CTRL_EMPTY;
+}
+
+// returns the arrays of t to the heap (unless they are not t's own)
+// and leaves t with none
+void HashTable::release(Table& t)
+{
+   if (t.owned)
+   {
+      delete [] t.data;
+      delete [] t.ctrl;
+      delete [] t.counts;
+   }
+   t.data = 0;
+   t.ctrl = 0;
+   t.counts = 0;
+   t.capacity = 0;
+   t.mask = 0;
+   t.owned = false;
+}
+
+// returns true if a len-character word (and its null terminator) can
+// be added to the arena with its offset still clear of MAPPED_WORD
+// (which marks a word in dict_file instead), otherwise returns false
+bool HashTable::arena_has_room(size_type len) const
+{ return arena_used + len + 1 <= MAPPED_WORD; }
+
+// copies the len-character word (adding a null terminator) to the
+// end of the arena, doubling the arena when it runs out of room, and
+// returns the offset at which the copy starts (the caller makes sure
+// there is room, see arena_has_room)
+uint32_t HashTable::store_word(const char* word, size_type len)
+{
+   if (arena_used + len + 1 > arena_cap)
+   {
+      size_type new_cap = 2 * arena_cap;
+      while (new_cap < arena_used + len + 1) new_cap *= 2;
+      char* temp = new char[new_cap];
+      memcpy(temp, arena, arena_used);
+      delete [] arena;
+      arena = temp;
+      arena_cap = new_cap;
+   }
+   uint32_t offset = uint32_t(arena_used);
+   memcpy(arena + arena_used, word, len);
+   arena[arena_used + len] = '\0';
+   arena_used += len + 1;
+   return offset;
+}
+
+// item is copied into the first vacant (or deleted) slot of its
+// (group-wise) quadratic probe sequence in t, whose index is returned
+// (no load-factor check is done, and used is left to the caller)
+// (t is always table, the only table erase leaves tombstones in)
+HashTable::size_type HashTable::place(const Table& t, const Slot& item,
+                                      uint32_t count) const
+{
+   if(opts.probing == ROBIN_HOOD_PROBING)
+       return rh_place(t, item, count);
+   Probe p = probe_start(t, item.fingerprint);
+
+   while(p.index < t.capacity){
+       uint32_t m = CtrlGroup(t.ctrl + p.location).match_vacant();
+       if(m != 0){
+           size_type i = slot_index(t, p.location, lowest_bit(m));
+           if(t.ctrl[i] == CTRL_DELETED)
+               tombstones--;
+           t.data[i] = item;
+           set_count(t, i, count);
+           set_ctrl(t, i, ctrl_tag(item.fingerprint));
+           count_probes(p.index + 1);
+           return i;
+       }
+       probe_next(t, p);
+   }
+   return t.capacity;
 }
 
 // constructs an empty initial hash table
-HashTable::HashTable(size_type initial_capacity)
-          : capacity(initial_capacity), used(0)
+HashTable::HashTable(size_type initial_capacity, const Options& options)
+          : opts(options), old_used(0), migrated(0), used(0),
+            tombstones(0), long_probe(false), counted(false), arena_used(0),
+            arena_cap(8 * INIT_CAP), counters(), op_probes(0)
 {
+   size_type capacity = initial_capacity;
    if (capacity < 11)
-      capacity = next_prime(INIT_CAP);
-   else if ( ! is_prime(capacity))
-      capacity = next_prime(capacity);
-   data = new Item[capacity];
-   for (size_type i = 0; i < capacity; ++i)
-      strcpy(data[i].word, "");
+      capacity = allowed_capacity(INIT_CAP);
+   else
+      capacity = allowed_capacity(capacity);
+   allocate(table, capacity, false);
+   old_table.data = 0;
+   old_table.ctrl = 0;
+   old_table.counts = 0;
+   old_table.capacity = 0;
+   old_table.mask = 0;
+   old_table.owned = false;
+   arena = new char[arena_cap];
+   build_filter();
 }
 
 // returns dynamic memory used by the hash table to heap
-HashTable::~HashTable() { delete [] data; }
+HashTable::~HashTable()
+{
+   release(table);
+   release(old_table);
+   delete [] arena;
+}
 
 // returns the hash table's current capacity
 HashTable::size_type HashTable::cap() const
-{ return capacity; }
+{ return table.capacity; }
 
 // returns the # of hash-table slots currently in use (non-vacant)
 HashTable::size_type HashTable::size() const
 { return used; }
 
+// returns the function hashing the words (see hash_word)
+HashTable::hash_policy HashTable::hasher() const
+{ return opts.hasher; }
+
 // graphs a horizontal histogram that gives a decent idea of how
 // items are distributed over the hash table
 void HashTable::scat_plot(ostream& out) const
 {
+   finish_rehash();
    out << endl << "Scatter plot of where hash table is used:";
    size_type lo_index = 0,
-             hi_index = capacity - 1,
+             hi_index = table.capacity - 1,
              width;
-   if (capacity >= 100000)
-      width = capacity / 250;
-   else if (capacity >= 10000)
-      width = capacity / 25;
+   if (table.capacity >= 100000)
+      width = table.capacity / 250;
+   else if (table.capacity >= 10000)
+      width = table.capacity / 25;
    else
-      width = capacity / 10;
+      width = table.capacity / 10;
    size_type max_digits = size_type( floor( log10(hi_index) ) + 1 ),
              label_beg  = lo_index,
              label_end  = label_beg + width - 1;
@@ -127,7 +1104,7 @@ void HashTable::scat_plot(ostream& out) const
       size_type i = label_beg;
       while ( i <= label_end && i <= hi_index)
       {
-         if (data[i].word[0] != '\0')
+         if (in_use(table, i))
             out << '*';
          ++i;
       }
@@ -139,36 +1116,572 @@ void HashTable::scat_plot(ostream& out) const
 // dumping to out contents of "segment of slots" of the hash table
 void HashTable::grading_helper_print(ostream& out) const
 {
+   finish_rehash();
    out << endl << "Content of selected hash table segment:\n";
    for (size_type i = 10; i < 30; ++i)
-      out << '[' << i << "]: " << data[i].word << endl;
+   {
+      out << '[' << i << "]: ";
+      if (in_use(table, i))
+         out.write(word_at(table.data[i]), word_length(table.data[i]));
+      out << endl;
+   }
+}
+
+// calls visit with each word in the hash table (in slot order) and
+// context
+void HashTable::for_each_word(word_visitor visit, void* context) const
+{
+   finish_rehash();
+   for (size_type i = 0; i < table.capacity; ++i)
+      if (in_use(table, i))
+         visit(word_at(table.data[i]), word_length(table.data[i]), context);
 }
 
 // cStr (assumed to be currently non-existant in the hash table)
 // is inserted into the hash table, using the djb2 hash function
 // and quadratic probing for collision resolution
 // (if the insertion results in the load-factor exceeding 0.45,
-// rehash is called to bring down the load-factor)
-void HashTable::insert(const char* cStr)
+// rehash is called to bring down the load-factor); returns false
+// (inserting nothing) if the arena has no room left for cStr (see
+// arena_has_room), otherwise returns true
+bool HashTable::insert(const char* cStr)
 {
-   size_type location, startLocation, i = 0;
-   startLocation = hash(cStr);
-   location = startLocation;
+   size_type len = strlen(cStr);
+   if( ! arena_has_room(len) )
+       return false;
+   migrate(MIGRATE_STEP);
+   begin_op();
+   Slot item;
+   item.fingerprint = hash(cStr, len);
+   item.offset = store_word(cStr, len);
+   place(table, item, 0);
+   add_to_filter(item.fingerprint);
+   used++;
+   end_op(INSERT_OP);
 
-   while(i < capacity){
-       if(data[location].word[0] == '\0'){
-           strcpy(data[location].word, cStr);
-           used++;
-           break;
+   if(max_load() < load_factor() || (long_probe && 2 * load_factor() > max_load()))
+       rehash();
+   return true;
+}
+
+// cStr is inserted into the hash table (as done by insert above)
+// unless it already exists there, which is detected while probing
+// for the vacant slot; returns true if cStr was inserted, otherwise
+// (it was there, or the arena has no room left for it) returns false
+bool HashTable::insert_if_absent(const char* cStr)
+{ return add(cStr, strlen(cStr), true); }
+
+// the len-character word is inserted, with count count, unless it
+// already exists in the hash table (count is then added to its
+// count); the word is copied into the arena if copy is true,
+// otherwise it must lie in dict_file and is referred to in place;
+// returns true if the word was inserted, otherwise (it was there, or
+// it is to be copied and the arena has no room left) returns false
+bool HashTable::add(const char* word, size_type len, bool copy,
+                    uint32_t count)
+{
+   migrate(MIGRATE_STEP);
+   begin_op();
+   uint32_t fingerprint = hash(word, len);
+   size_type vacant = table.capacity;
+   size_type old_vacant;
+   size_type i = table.capacity;
+   size_type old_i = old_table.capacity;
+   // a word the Bloom filter turns away is not there, so place can
+   // find it a slot without looking for it first
+   bool known = opts.bloom_bits == 0 || filter.may_contain(fingerprint);
+   if(known)
+       i = find(table, word, len, fingerprint, vacant);
+   if(known && i == table.capacity && old_table.data != 0)
+       old_i = find(old_table, word, len, fingerprint, old_vacant);
+   if(i != table.capacity || old_i != old_table.capacity){
+       if(i != table.capacity)
+           add_count(table, i, count);
+       else
+           add_count(old_table, old_i, count);
+       end_op(INSERT_OP);
+       return false;
+   }
+   if(copy && ! arena_has_room(len)){
+       end_op(INSERT_OP);
+       return false;
+   }
+
+   Slot item;
+   item.fingerprint = fingerprint;
+   if(copy)
+       item.offset = store_word(word, len);
+   else
+       item.offset = MAPPED_WORD | uint32_t(word - dict_file.data());
+   if(vacant == table.capacity)
+       place(table, item, count);
+   else{
+       if(table.ctrl[vacant] == CTRL_DELETED)
+           tombstones--;
+       table.data[vacant] = item;
+       set_count(table, vacant, count);
+       set_ctrl(table, vacant, ctrl_tag(fingerprint));
+   }
+   add_to_filter(fingerprint);
+   used++;
+   end_op(INSERT_OP);
+
+   if(max_load() < load_factor() || (long_probe && 2 * load_factor() > max_load()))
+       rehash();
+   return true;
+}
+
+// cStr is removed from the hash table if it is there: its slot is
+// marked deleted (a tombstone), not vacant, so the probe sequences
+// running through it still reach the items beyond it, and it is
+// reused by a later insert; once tombstones take up more than
+// MAX_TOMBSTONES of the slots, the hash table is cleaned up in place
+// (see drop_tombstones); under Robin Hood probing, the items after
+// it are shifted back instead (see rh_remove); returns true if cStr
+// was removed, otherwise returns false
+bool HashTable::erase(const char* cStr)
+{
+   migrate(MIGRATE_STEP);
+   begin_op();
+   size_type len = strlen(cStr);
+   uint32_t fingerprint = hash(cStr, len);
+   size_type vacant;
+   size_type i = find(table, cStr, len, fingerprint, vacant);
+   size_type old_i = old_table.capacity;
+   if(i == table.capacity && old_table.data != 0)
+       old_i = find(old_table, cStr, len, fingerprint, vacant);
+   end_op(ERASE_OP);
+   if(i != table.capacity && opts.probing == ROBIN_HOOD_PROBING){
+       rh_remove(table, i);
+       used--;
+       return true;
+   }
+   if(i != table.capacity){
+       set_ctrl(table, i, CTRL_DELETED);
+       tombstones++;
+       used--;
+       check_tombstones();
+       return true;
+   }
+   if(old_i == old_table.capacity)
+       return false;
+   set_ctrl(old_table, old_i, CTRL_DELETED);
+   old_used--;
+   used--;
+   return true;
+}
+
+// the n words are inserted (skipping those already in the hash table)
+// after growing the hash table once, up front, to hold them all;
+// returns the # of words inserted
+HashTable::size_type HashTable::insert_range(const char* const* words,
+                                             size_type n)
+{
+   reserve(used + n);
+   size_type inserted = 0;
+   for(size_type i = 0; i < n; ++i)
+       if(insert_if_absent(words[i]))
+           inserted++;
+   return inserted;
+}
+
+// grows the hash table (if needed) so that it can hold n items
+// without the load-factor exceeding its limit, i.e. without
+// rehashing along the way
+void HashTable::reserve(size_type n)
+{
+   if(double(n) / table.capacity <= max_load())
+       return;
+   resize(allowed_capacity(size_type(n / max_load()) + 1));
+}
+
+// maps the (whitespace-separated) words of the dictionary file
+// filename into memory and inserts those not already in the hash
+// table, without copying them: each slot refers to its word in the
+// mapping, which stays in place for the life of the hash table
+// (only a last word running up to the very end of the file, with no
+// whitespace after it, is copied); if the first line of the file is
+// a word followed by a count (a token of digits), the file has a
+// count column: each count is the count of the word before it (see
+// count), and is not itself inserted; returns false if the file
+// cannot be mapped or a dictionary file has already been loaded,
+// otherwise returns true
+bool HashTable::load_mapped(const char* filename)
+{
+   if(dict_file.is_open() || ! dict_file.open(filename))
+       return false;
+   if(dict_file.size() >= MAPPED_WORD){
+       dict_file.close();
+       return false;
+   }
+   const char* beg = dict_file.data();
+   const char* end = beg + dict_file.size();
+   if(has_count_column(beg, end))
+       keep_counts();
+
+   // count the words first so the hash table is sized only once
+   size_type count = 0;
+   scan_words(beg, end, end, [this, &count](const char* word, size_t len) {
+       if( ! (counted && is_count(word, len)) ) count++;
+   });
+   reserve(used + count);
+
+   // with counts, a word is held back until the token after it shows
+   // whether it has a count
+   const char* held = 0;
+   size_t held_len = 0;
+   scan_words(beg, end, end, [&](const char* word, size_t len) {
+       if( ! counted ){
+           add(word, len, word + len == end, 0);
+           return;
        }
-       else{
-           i++;
-           location = ((startLocation + (i * i)) % capacity);
+       bool has_count = is_count(word, len);
+       if(held != 0)
+           add(held, held_len, held + held_len == end,
+               has_count ? parse_count(word, len) : 0);
+       held = has_count ? 0 : word;
+       held_len = len;
+   });
+   if(held != 0)
+       add(held, held_len, held + held_len == end, 0);
+   return true;
+}
+
+// does what load_mapped does, but with the work shared among threads
+// threads (all the hardware has if 0): the file is split into one
+// chunk per thread, each thread tokenizes and hashes its chunk, and
+// the words are then partitioned by home slot so that each thread
+// fills its own region of the (presized) hash table; only the few
+// words whose probe sequence leaves their region are inserted
+// afterwards, one at a time (under Robin Hood probing, where an
+// insert may move items anywhere along the way, load_mapped does all
+// the work); returns false if the file cannot be mapped or a
+// dictionary file has already been loaded, otherwise returns true
+bool HashTable::load_parallel(const char* filename, unsigned threads)
+{
+   if(threads == 0)
+       threads = thread::hardware_concurrency();
+   if(threads < 2 || opts.probing == ROBIN_HOOD_PROBING)
+       return load_mapped(filename);
+   if(dict_file.is_open() || ! dict_file.open(filename))
+       return false;
+   if(dict_file.size() >= MAPPED_WORD){
+       dict_file.close();
+       return false;
+   }
+   size_type size = dict_file.size();
+   if(has_count_column(dict_file.data(), dict_file.data() + size))
+       keep_counts();
+   vector<thread> pool;
+
+   // 1. each thread tokenizes and hashes its chunk of the file
+   vector<PendingList> chunks(threads);
+   for(unsigned c = 0; c < threads; ++c)
+       pool.push_back(thread(&HashTable::tokenize, this, size * c / threads,
+                             size * (c + 1) / threads, ref(chunks[c])));
+   for(unsigned c = 0; c < threads; ++c)
+       pool[c].join();
+   pool.clear();
+   size_type count = 0;
+   for(unsigned c = 0; c < threads; ++c)
+       count += chunks[c].size();
+   finish_rehash();
+   reserve(used + count);
+
+   // 2. each thread sorts the words of its chunk by the region of the
+   //    hash table their home slot is in (bucket c * threads + r holds
+   //    the words of chunk c bound for region r)
+   vector<PendingList> buckets(threads * threads);
+   for(unsigned c = 0; c < threads; ++c)
+       pool.push_back(thread([this, c, threads, &chunks, &buckets]() {
+           const PendingList& words = chunks[c];
+           for(size_type i = 0; i < words.size(); ++i){
+               size_type home = probe_start(table, words[i].fingerprint).location;
+               buckets[c * threads + home * threads / table.capacity]
+                  .push_back(words[i]);
+           }
+           PendingList().swap(chunks[c]);
+       }));
+   for(unsigned c = 0; c < threads; ++c)
+       pool[c].join();
+   pool.clear();
+
+   // 3. each thread fills its region of the hash table
+   vector<PendingList> deferred(threads);
+   vector<size_type> inserted(threads);
+   for(unsigned r = 0; r < threads; ++r)
+       pool.push_back(thread([this, r, threads, &buckets, &deferred, &inserted]() {
+           inserted[r] = fill_region(table.capacity * r / threads,
+                                     table.capacity * (r + 1) / threads,
+                                     &buckets[r], threads, threads,
+                                     deferred[r]);
+       }));
+   for(unsigned r = 0; r < threads; ++r){
+       pool[r].join();
+       used += inserted[r];
+   }
+   build_filter();
+
+   // 4. the words left over are inserted as load_mapped would
+   const char* beg = dict_file.data();
+   for(unsigned r = 0; r < threads; ++r)
+       for(size_type i = 0; i < deferred[r].size(); ++i){
+           const Pending& word = deferred[r][i];
+           add(beg + word.offset, word.length,
+               word.offset + word.length == size, word.count);
+       }
+   return true;
+}
+
+// appends to words the words (of the mapped dictionary file) that
+// start at an index in [beg, end) of dict_file, hashed; a word
+// running on past end is included whole, and one running on from
+// before beg is left to the chunk it started in
+// (with counts, each count goes with the word before it, even if it
+// lies past end, and a count the chunk starts with is left to the
+// chunk before)
+void HashTable::tokenize(size_type beg, size_type end, PendingList& words) const
+{
+   const char* text = dict_file.data();
+   size_type size = dict_file.size();
+   size_type p = beg;
+   if(p > 0)
+       while(p < size && ! is_delim(text[p - 1]) && ! is_delim(text[p])) ++p;
+   if(p >= end)
+       return;
+   bool counting = counted;
+   bool last_is_word = false;
+   scan_words(text + p, text + end, text + size,
+              [this, text, counting, &words, &last_is_word](const char* chars,
+                                                           size_t len) {
+       if(counting && is_count(chars, len)){
+           if(last_is_word)
+               words.back().count = parse_count(chars, len);
+           last_is_word = false;
+           return;
+       }
+       Pending word;
+       word.offset = uint32_t(chars - text);
+       word.length = uint32_t(len);
+       word.fingerprint = hash(chars, len);
+       word.count = 0;
+       words.push_back(word);
+       last_is_word = true;
+   });
+   if( ! counting || ! last_is_word )
+       return;
+   const char* next = text + words.back().offset + words.back().length;
+   while(next < text + size && is_delim(*next)) ++next;
+   size_t len = 0;
+   while(next + len < text + size && ! is_delim(next[len])) ++len;
+   if(len > 0 && is_count(next, len))
+       words.back().count = parse_count(next, len);
+}
+
+// the words in lists[0], lists[stride], ... (n_lists lists in all),
+// whose home slots all lie in [lo, hi), are inserted (if not already
+// in the hash table) as long as their probe sequences stay within
+// the groups lying wholly in [lo, hi), so that threads filling
+// different regions never touch the same slots; the words whose
+// probe sequences lead out of the region (and a last word running up
+// to the very end of the file, which has to be copied) are appended
+// to deferred instead; returns the # of words inserted (used is left
+// to the caller)
+HashTable::size_type HashTable::fill_region(size_type lo, size_type hi,
+                                            const PendingList* lists,
+                                            size_type n_lists,
+                                            size_type stride,
+                                            PendingList& deferred)
+{
+   const char* text = dict_file.data();
+   size_type inserted = 0;
+   for(size_type l = 0; l < n_lists; ++l){
+       const PendingList& words = lists[l * stride];
+       for(size_type w = 0; w < words.size(); ++w){
+           const Pending& word = words[w];
+           const char* chars = text + word.offset;
+           int8_t tag = ctrl_tag(word.fingerprint);
+           Probe p = probe_start(table, word.fingerprint);
+           bool settled = false;
+           while( ! settled && p.index < table.capacity &&
+                 p.location >= lo && p.location + GROUP_WIDTH <= hi &&
+                 word.offset + word.length < dict_file.size()){
+               CtrlGroup group(table.ctrl + p.location);
+               for(uint32_t m = group.match(tag); m != 0 && ! settled; m &= m - 1){
+                   size_type i = p.location + lowest_bit(m);
+                   settled = table.data[i].fingerprint == word.fingerprint &&
+                             same_word(table.data[i], chars, word.length);
+                   if(settled)
+                       add_count(table, i, word.count);
+               }
+               uint32_t empty = group.match_empty();
+               if( ! settled && empty != 0){
+                   size_type i = p.location + lowest_bit(empty);
+                   table.data[i].fingerprint = word.fingerprint;
+                   table.data[i].offset = MAPPED_WORD | word.offset;
+                   set_count(table, i, word.count);
+                   set_ctrl(table, i, tag);
+                   inserted++;
+                   settled = true;
+               }
+               probe_next(table, p);
+           }
+           if( ! settled)
+               deferred.push_back(word);
        }
    }
+   return inserted;
+}
 
-   if(0.45 < load_factor())
-       rehash();
+// writes the hash table to filename as an image that open_image can
+// map back in as is: a header (see ImageHeader) followed by the
+// control bytes, the slots and then the words, each null-terminated,
+// with every slot's offset rewritten to where its word is in the
+// image; returns true if the image was written, otherwise false
+bool HashTable::save_image(const char* filename) const
+{
+   finish_rehash();
+   size_type capacity = table.capacity;
+   ImageHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+   header.version = IMAGE_VERSION;
+   header.group_width = GROUP_WIDTH;
+   header.sizing = table.mask ? POWER_OF_TWO_SIZING : PRIME_SIZING;
+   header.hasher = opts.hasher;
+   header.probing = opts.probing;
+   header.capacity = capacity;
+   header.used = used;
+   header.tombstones = tombstones;
+   header.ctrl_offset = sizeof(header);
+   header.slot_offset = (header.ctrl_offset + capacity + GROUP_WIDTH - 1
+                         + sizeof(Slot) - 1) / sizeof(Slot) * sizeof(Slot);
+   header.word_offset = header.slot_offset + capacity * sizeof(Slot);
+   if(counted){
+       header.count_offset = header.word_offset;
+       header.word_offset += capacity * sizeof(uint32_t);
+   }
+
+   Slot* image_slots = new Slot[capacity];
+   uint64_t word_end = header.word_offset;
+   for(size_type i = 0; i < capacity; ++i){
+       image_slots[i].fingerprint = 0;
+       image_slots[i].offset = 0;
+       if(in_use(table, i)){
+           image_slots[i].fingerprint = table.data[i].fingerprint;
+           image_slots[i].offset = MAPPED_WORD | uint32_t(word_end);
+           word_end += word_length(table.data[i]) + 1;
+       }
+   }
+   header.file_size = word_end;
+   if(word_end > MAPPED_WORD){
+       delete [] image_slots;
+       return false;
+   }
+
+   ofstream out(filename, ios::out | ios::binary | ios::trunc);
+   out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+   out.write(reinterpret_cast<const char*>(table.ctrl),
+             capacity + GROUP_WIDTH - 1);
+   for(uint64_t pad = header.ctrl_offset + capacity + GROUP_WIDTH - 1;
+       pad < header.slot_offset; ++pad)
+       out.put('\0');
+   out.write(reinterpret_cast<const char*>(image_slots),
+             capacity * sizeof(Slot));
+   if(counted)
+       out.write(reinterpret_cast<const char*>(table.counts),
+                 capacity * sizeof(uint32_t));
+   for(size_type i = 0; i < capacity; ++i)
+       if(in_use(table, i)){
+           out.write(word_at(table.data[i]), word_length(table.data[i]));
+           out.put('\0');
+       }
+   delete [] image_slots;
+   out.close();
+   return ! out.fail();
+}
+
+// replaces the contents of the hash table with the image filename
+// (written by save_image), which is mapped into memory and used in
+// place, so no word is hashed and nothing is parsed or copied; the
+// mapping is private, so later changes never reach the file; returns
+// false (leaving the hash table unchanged) if the file cannot be
+// mapped or is not a valid image (down to the offset of every slot
+// in use), otherwise returns true
+bool HashTable::open_image(const char* filename)
+{
+   MappedFile image;
+   if( ! image.open(filename, true) || image.size() < sizeof(ImageHeader))
+       return false;
+   ImageHeader header;
+   memcpy(&header, image.data(), sizeof(header));
+   if(memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != IMAGE_VERSION ||
+      header.group_width != GROUP_WIDTH ||
+      (header.sizing != PRIME_SIZING &&
+       header.sizing != POWER_OF_TWO_SIZING) ||
+      (header.sizing == POWER_OF_TWO_SIZING) !=
+         ((header.capacity & (header.capacity - 1)) == 0) ||
+      header.hasher > WY_HASH || header.probing > ROBIN_HOOD_PROBING ||
+      header.file_size != image.size() || header.file_size > MAPPED_WORD ||
+      header.capacity == 0 || header.used + header.tombstones > header.capacity ||
+      header.ctrl_offset < sizeof(header) ||
+      header.slot_offset % sizeof(Slot) != 0 ||
+      header.slot_offset < header.ctrl_offset + header.capacity
+                           + GROUP_WIDTH - 1 ||
+      header.word_offset < header.slot_offset
+                           + header.capacity * sizeof(Slot) ||
+      (header.count_offset != 0 &&
+       (header.count_offset < header.slot_offset
+                              + header.capacity * sizeof(Slot) ||
+        header.count_offset % sizeof(uint32_t) != 0 ||
+        header.word_offset < header.count_offset
+                             + header.capacity * sizeof(uint32_t))) ||
+      header.word_offset > header.file_size ||
+      (header.file_size > header.word_offset &&
+       image.data()[header.file_size - 1] != '\0'))
+       return false;
+   // every slot in use must refer to a word among the image's words
+   // (which the null at the end of the image keeps word_length from
+   // running past), and the # of them must be used
+   const int8_t* ctrl = reinterpret_cast<const int8_t*>(image.data()
+                                                        + header.ctrl_offset);
+   const Slot* slots = reinterpret_cast<const Slot*>(image.data()
+                                                     + header.slot_offset);
+   size_type in_use_count = 0;
+   for(size_type i = 0; i < header.capacity; ++i)
+       if(ctrl[i] >= 0){
+           uint32_t at = slots[i].offset & ~MAPPED_WORD;
+           if( ! (slots[i].offset & MAPPED_WORD) ||
+               at < header.word_offset || at >= header.file_size)
+               return false;
+           in_use_count++;
+       }
+   if(in_use_count != header.used)
+       return false;
+
+   release(table);
+   release(old_table);
+   dict_file.swap(image); // (releasing whatever was mapped before)
+   table.ctrl = reinterpret_cast<int8_t*>(dict_file.data()
+                                           + header.ctrl_offset);
+   table.data = reinterpret_cast<Slot*>(dict_file.data()
+                                         + header.slot_offset);
+   table.counts = header.count_offset == 0 ? 0
+                  : reinterpret_cast<uint32_t*>(dict_file.data()
+                                                + header.count_offset);
+   table.capacity = header.capacity;
+   table.mask = (header.sizing == POWER_OF_TWO_SIZING) ? header.capacity - 1 : 0;
+   table.owned = false;
+   counted = header.count_offset != 0;
+   opts.sizing = sizing_policy(header.sizing);
+   opts.hasher = hash_policy(header.hasher);
+   opts.probing = probing_policy(header.probing);
+   used = header.used;
+   tombstones = header.tombstones;
+   arena_used = 0;
+   build_filter();
+   return true;
 }
 
 // adaption of : http://stackoverflow.com/questions/4475996
@@ -221,3 +1734,43 @@ HashTable::size_type next_prime(HashTable::size_type x)
         i ^= 6;
     return x;
 }
+
+// returns the 32-bit hash value of the len characters at word, using
+//   DJB2_HASH   the djb2 hash algorithm (2nd page of Lecture Note
+//               324s02AdditionalNotesOnHashFunctions), a byte at a time
+//   FNV1A_HASH  the 32-bit FNV-1a hash, a byte at a time
+//   WY_HASH     a wyhash-style hash that reads 8 bytes at a time and
+//               mixes them with 64x64->128-bit multiplies
+uint32_t hash_word(HashTable::hash_policy policy, const char* word,
+                   HashTable::size_type len)
+{
+   const unsigned char* p = reinterpret_cast<const unsigned char*>(word);
+   switch (policy)
+   {
+   case HashTable::FNV1A_HASH:
+   {
+      uint32_t hash = 2166136261u;
+      for (HashTable::size_type i = 0; i < len; ++i)
+         hash = (hash ^ p[i]) * 16777619u;
+      return hash;
+   }
+   case HashTable::WY_HASH:
+   {
+      uint64_t hash = wy_hash(p, len, WY_P0);
+      return uint32_t(hash ^ (hash >> 32));
+   }
+   default:
+   {
+      uint32_t hash = 5381;
+      for (HashTable::size_type i = 0; i < len; ++i)
+         hash = ((hash << 5) + hash) + p[i]; //hash * 33 + c
+      return hash;
+   }
+   }
+}
+
+// returns a 64-bit hash value of the len-character word, which seed
+// (any value) picks among a family of such hash functions (the
+// wyhash-style one WY_HASH folds to 32 bits, under seed 0)
+uint64_t hash_word64(const char* word, HashTable::size_type len, uint64_t seed)
+{ return wy_hash(reinterpret_cast<const unsigned char*>(word), len, seed ^ WY_P0); }
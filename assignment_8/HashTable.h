@@ -2,34 +2,251 @@
 #define HASH_TABLE
 
 #include <cstdlib>  // for use of size_t
+#include <cstdint>  // for use of uint32_t
 #include <iostream> // for use of ostream
+#include <vector>   // for use of vector
+#include <chrono>   // for use of steady_clock
+#include "CtrlGroup.h"
+#include "MappedFile.h"
+#include "BloomFilter.h"
 
 class HashTable
 {
 public:
    typedef size_t size_type;
    static const size_type INIT_CAP = 101;
-   // default | 1-argument constructor
-   HashTable(size_type initial_capacity = INIT_CAP);
+   // how capacities are chosen: prime (hash value reduced modulo
+   // capacity) or a power of two (hash value mixed, then masked)
+   enum sizing_policy { PRIME_SIZING, POWER_OF_TWO_SIZING };
+   // which function hashes the words (see hash_word)
+   enum hash_policy { DJB2_HASH, FNV1A_HASH, WY_HASH };
+   // how collisions are resolved: group-wise quadratic probing, or
+   // Robin Hood linear probing (which runs at a higher load-factor)
+   enum probing_policy { QUADRATIC_PROBING, ROBIN_HOOD_PROBING };
+   // a function for_each_word calls with each word (which is not
+   // null-terminated) and the context it was given
+   typedef void (*word_visitor)(const char* word, size_type len,
+                                void* context);
+   // # of buckets of Stats::probe_histogram
+   static const size_type PROBE_BUCKETS = 16;
+   // what the operations of a hash table built with collect_stats
+   // have cost since it was constructed (or reset_stats was called),
+   // probe lengths being counted in groups (in slots, under Robin Hood
+   // probing), along with the shape of the hash table (see stats)
+   // (the words load_parallel places from its threads are not counted)
+   struct Stats
+   {
+      size_type searches;      // search, search_hashed, search_batch words
+      size_type inserts;       // insert, insert_if_absent, loaded words
+      size_type erases;
+      size_type search_probes; // total probe length of each kind
+      size_type insert_probes; // of operation
+      size_type erase_probes;
+      size_type probe_histogram[PROBE_BUCKETS]; // # of operations of
+                               // probe length k + 1 (in the last
+                               // bucket, of that length or more)
+      size_type max_probe;     // longest probe of an operation
+      size_type rehashes;      // # of times the slots were reallocated
+      double rehash_seconds;   // (wall-clock) time they took
+      size_type cleanups;      // # of in-place tombstone cleanups
+      size_type max_displacement; // farthest an item now lies past
+                               // the first group (slot) it probes
+      size_type bytes_allocated;  // heap bytes the slots, control
+                               // bytes, arena and Bloom filter now
+                               // take up
+      size_type bloom_rejects; // searches the Bloom filter answered
+                               // without probing
+      size_type bloom_false_positives; // searches it let through for
+                               // words that were not there
+   };
+   // options fixed when the hash table is constructed
+   struct Options
+   {
+      bool incremental_rehash; // spread each rehash over the operations
+                               // that follow it rather than doing it
+                               // all at once
+      sizing_policy sizing;
+      hash_policy hasher;
+      probing_policy probing;
+      bool collect_stats;      // keep Stats (costing a little time on
+                               // every operation)
+      unsigned bloom_bits;     // bits per word of a Bloom filter that
+                               // searches check before probing, to
+                               // turn away most words not there
+                               // (0 for no filter)
+      Options() : incremental_rehash(false), sizing(PRIME_SIZING),
+                  hasher(DJB2_HASH), probing(QUADRATIC_PROBING),
+                  collect_stats(false), bloom_bits(0) { }
+   };
+   // default | 1-argument | 2-argument constructor
+   HashTable(size_type initial_capacity = INIT_CAP,
+             const Options& options = Options());
    ~HashTable();
    size_type cap() const;
    size_type size() const;
+   hash_policy hasher() const;
    bool exists(const char* cStr) const;
    bool search(const char* cStr) const;
+   bool search_hashed(const char* word, size_type len,
+                      uint32_t fingerprint, uint32_t* count = 0) const;
+   uint32_t count(const char* cStr) const;
+   bool has_counts() const;
+   void search_batch(const char* const* words, size_type n, bool* out) const;
    double load_factor() const;
+   double avg_probe_length() const;
+   size_type bloom_bytes() const;
+   double bloom_fp_rate() const;
+   Stats stats() const;
+   void reset_stats();
+   void dump_stats(std::ostream& out) const;
    void scat_plot(std::ostream& out) const;
    void grading_helper_print(std::ostream& out) const;
-   void insert(const char* cStr);
+   void for_each_word(word_visitor visit, void* context) const;
+   bool insert(const char* cStr);
+   bool insert_if_absent(const char* cStr);
+   bool erase(const char* cStr);
+   size_type insert_range(const char* const* words, size_type n);
+   void reserve(size_type n);
+   bool load_mapped(const char* filename);
+   bool load_parallel(const char* filename, unsigned threads = 0);
+   bool save_image(const char* filename) const;
+   bool open_image(const char* filename);
 private:
-   struct Item
+   // a slot keeps only the word's full hash value (its fingerprint)
+   // and where the word's characters start in the string arena, so
+   // probing touches 8 bytes per slot and the word itself is only
+   // compared when the fingerprints agree
+   // (with MAPPED_WORD set in offset, the word is instead at
+   // offset & ~MAPPED_WORD in dict_file, where it ends at the first
+   // whitespace character rather than at a null character)
+   struct Slot
+   {
+      uint32_t fingerprint;
+      uint32_t offset;
+   };
+   static const uint32_t MAPPED_WORD = 0x80000000u;
+   // under Robin Hood probing, the control byte of a slot in use holds
+   // the distance of the slot from the item's home slot instead of a
+   // tag, saturating at MAX_DISTANCE (a distance that large also makes
+   // the hash table grow)
+   static const int8_t MAX_DISTANCE = 127;
+   // an array of slots along with their control bytes; while an
+   // incremental rehash is under way there are two of these
+   // (the arrays are written through a const Table& as well: moving
+   // items from one table to the other, as a search may do, leaves
+   // the contents of the hash table unchanged)
+   struct Table
+   {
+      Slot* data;
+      int8_t* ctrl;       // capacity control bytes (see CtrlGroup.h),
+                          // followed by copies of the first
+                          // GROUP_WIDTH - 1 so a group never wraps
+      size_type capacity;
+      size_type mask;     // capacity - 1 if capacity is a power of two
+                          // (otherwise 0)
+      uint32_t* counts;   // capacity word counts, parallel to data
+                          // (0 if the hash table keeps no counts)
+      bool owned;         // false if data, ctrl and counts lie in
+                          // dict_file (after open_image, until resized)
+   };
+   // a word of the mapped dictionary file waiting to be inserted by
+   // load_parallel: where it starts in dict_file, its length, its
+   // hash value and its count
+   struct Pending
+   {
+      uint32_t offset;
+      uint32_t length;
+      uint32_t fingerprint;
+      uint32_t count;
+   };
+   typedef std::vector<Pending> PendingList;
+   // where a probe sequence is at: the group starting at location,
+   // which is the index-th visited, with the next delta slots on
+   struct Probe
    {
-      char word[101];  // for holding a C-string (null-terminated)
+      size_type location;
+      size_type delta;
+      size_type index;
    };
-   Item* data;
-   size_type capacity; // hash table capacity
+   // the kinds of operation Stats counts
+   enum op_kind { SEARCH_OP, INSERT_OP, ERASE_OP };
+   Options opts;
+   Table table;                // where items are inserted
+   mutable Table old_table;    // table being rehashed from (data is 0
+                               // if no incremental rehash is under way)
+   mutable size_type old_used; // # of items still in old_table
+   mutable size_type migrated; // old_table slots below this index have
+                               // had their items moved to table
    size_type used;     // # of hash table elements used (non-vacant)
-   size_type hash(const char* word) const;
+   mutable size_type tombstones; // # of slots of table marked
+                                 // CTRL_DELETED by erase
+   mutable bool long_probe; // a Robin Hood item has been placed
+                            // MAX_DISTANCE or more slots from home
+   bool counted;          // the slots have counts (see Table::counts)
+   char* arena;           // null-terminated words stored back to back
+   size_type arena_used;  // # of arena bytes holding words
+   size_type arena_cap;   // # of arena bytes allocated
+   MappedFile dict_file;  // dictionary file (or image) mapped by
+                          // load_mapped (or open_image), if any
+   mutable BloomFilter filter; // the fingerprints of the words (with
+                               // bloom_bits), including some erased
+                               // since it was last built
+   mutable BloomFilter next_filter; // during an incremental rehash,
+                                    // the filter sized for table, which
+                                    // items join as they migrate or are
+                                    // inserted, and which replaces
+                                    // filter once old_table is emptied
+   mutable Stats counters;      // kept only with collect_stats
+   mutable size_type op_probes; // probe length of the operation under
+                                // way (with collect_stats)
+   uint32_t hash(const char* word, size_type len) const;
+   const char* word_at(const Slot& item) const;
+   size_type word_length(const Slot& item) const;
+   bool same_word(const Slot& item, const char* word, size_type len) const;
+   static bool in_use(const Table& t, size_type i);
+   static void set_ctrl(const Table& t, size_type i, int8_t value);
+   static uint32_t count_at(const Table& t, size_type i);
+   static void set_count(const Table& t, size_type i, uint32_t count);
+   static void add_count(const Table& t, size_type i, uint32_t count);
+   void keep_counts();
+   static size_type slot_index(const Table& t, size_type pos, unsigned k);
+   static void allocate(Table& t, size_type capacity, bool with_counts);
+   size_type allowed_capacity(size_type n) const;
+   double max_load() const;
+   static Probe probe_start(const Table& t, uint32_t fingerprint);
+   static void probe_next(const Table& t, Probe& p);
+   static void release(Table& t);
+   bool arena_has_room(size_type len) const;
+   uint32_t store_word(const char* word, size_type len);
+   bool add(const char* word, size_type len, bool copy, uint32_t count = 0);
+   size_type find(const Table& t, const char* word, size_type len,
+                  uint32_t fingerprint, size_type& vacant) const;
+   bool lookup(const char* word, size_type len, uint32_t fingerprint,
+               uint32_t* count = 0) const;
+   size_type place(const Table& t, const Slot& item, uint32_t count) const;
+   size_type rh_find(const Table& t, const char* word, size_type len,
+                     uint32_t fingerprint) const;
+   size_type rh_place(const Table& t, const Slot& item, uint32_t count) const;
+   void rh_remove(const Table& t, size_type i) const;
+   static size_type rh_distance(const Table& t, uint32_t fingerprint,
+                                size_type i);
+   size_type probe_length(const Table& t, size_type i) const;
+   void count_probes(size_type probes) const;
+   void begin_op() const;
+   void end_op(op_kind kind) const;
+   void count_rehash(std::chrono::steady_clock::time_point beg) const;
+   void tokenize(size_type beg, size_type end, PendingList& words) const;
+   size_type fill_region(size_type lo, size_type hi,
+                         const PendingList* lists, size_type n_lists,
+                         size_type stride, PendingList& deferred);
+   void migrate(size_type steps) const;
+   void finish_rehash() const;
+   void resize(size_type new_capacity);
+   void drop_tombstones();
+   void check_tombstones();
    void rehash();
+   void build_filter();
+   void add_to_filter(uint32_t fingerprint);
 
    // disable copy construction & copy assignment
    HashTable(const HashTable& src) { }
@@ -39,5 +256,9 @@ private:
 // non-member utility functions
 bool is_prime(HashTable::size_type num);
 HashTable::size_type next_prime(HashTable::size_type x);
+uint32_t hash_word(HashTable::hash_policy policy, const char* word,
+                   HashTable::size_type len);
+uint64_t hash_word64(const char* word, HashTable::size_type len,
+                     uint64_t seed);
 
 #endif
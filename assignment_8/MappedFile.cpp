@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// constructs a MappedFile with no file mapped
+MappedFile::MappedFile() : base(0), length(0), opened(false) { }
+
+// releases the mapping (if any)
+MappedFile::~MappedFile() { close(); }
+
+// maps the whole of filename into memory (read-only, or private and
+// writable if writable is true), releasing any mapping held before;
+// returns true on success, otherwise returns false (and nothing is
+// mapped)
+bool MappedFile::open(const char* filename, bool writable)
+{
+   close();
+   int fd = ::open(filename, O_RDONLY);
+   if (fd < 0)
+      return false;
+   struct stat info;
+   if (fstat(fd, &info) != 0)
+   {
+      ::close(fd);
+      return false;
+   }
+   length = size_type(info.st_size);
+   if (length > 0)
+   {
+      int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+      void* p = mmap(0, length, prot, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+      {
+         ::close(fd);
+         length = 0;
+         return false;
+      }
+      base = static_cast<char*>(p);
+   }
+   ::close(fd); // the mapping stays valid without the descriptor
+   opened = true;
+   return true;
+}
+
+// releases the mapping (if any)
+void MappedFile::close()
+{
+   if (base != 0)
+      munmap(base, length);
+   base = 0;
+   length = 0;
+   opened = false;
+}
+
+// exchanges the mappings held by this and other
+void MappedFile::swap(MappedFile& other)
+{
+   char* temp_base = base;
+   size_type temp_length = length;
+   bool temp_opened = opened;
+   base = other.base;
+   length = other.length;
+   opened = other.opened;
+   other.base = temp_base;
+   other.length = temp_length;
+   other.opened = temp_opened;
+}
+
+// returns true if a file is currently mapped
+bool MappedFile::is_open() const
+{ return opened; }
+
+// returns the address of the first byte of the mapped file
+// (0 when no file, or an empty file, is mapped)
+const char* MappedFile::data() const
+{ return base; }
+
+// (writable version, to be used only if the mapping is writable)
+char* MappedFile::data()
+{ return base; }
+
+// returns the # of bytes mapped
+MappedFile::size_type MappedFile::size() const
+{ return length; }
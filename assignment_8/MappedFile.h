@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <cstdlib>  // for use of size_t
+
+// a view of a whole file mapped into memory (with mmap); the mapping
+// is read-only unless opened as writable, in which case it is private
+// (copy-on-write) so changes are never written back to the file; the
+// mapping is released by close() or when the object goes away
+class MappedFile
+{
+public:
+   typedef size_t size_type;
+   MappedFile();
+   ~MappedFile();
+   bool open(const char* filename, bool writable = false);
+   void close();
+   void swap(MappedFile& other);
+   bool is_open() const;
+   const char* data() const;
+   char* data();
+   size_type size() const;
+private:
+   char* base;         // start of the mapping (0 if file is empty)
+   size_type length;   // # of bytes mapped
+   bool opened;
+
+   // disable copy construction & copy assignment
+   MappedFile(const MappedFile& src) { }
+   void operator=(const MappedFile& rhs) { }
+};
+
+#endif
@@ -0,0 +1,46 @@
+// FILE: MphBuild.cpp
+// Builds, offline, the minimal perfect hash of the words of a
+// dictionary file (see PerfectHash.h) for read-only deployments,
+// which then open it with a PerfectHashTable; run as
+//    mphbuild dictionary output
+// (dict1.txt and dict1.mph if not given)
+#include "HashTable.h"
+#include "PerfectHash.h"
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+   const char* dictName = argc > 1 ? argv[1] : "dict1.txt";
+   const char* outName  = argc > 2 ? argv[2] : "dict1.mph";
+   HashTable words;
+   if ( ! words.load_mapped(dictName) )
+   {
+      cerr << "Failed to open dictionary file " << dictName << endl;
+      return EXIT_FAILURE;
+   }
+   chrono::steady_clock::time_point beg = chrono::steady_clock::now();
+   PerfectHashBuilder builder(words);
+   double secs = chrono::duration<double>(chrono::steady_clock::now()
+                                          - beg).count();
+   if ( ! builder.built() || ! builder.save(outName) )
+   {
+      cerr << "Failed to build " << outName << endl;
+      return EXIT_FAILURE;
+   }
+   PerfectHashTable table;
+   if ( ! table.open(outName) )
+   {
+      cerr << "Failed to open " << outName << " once built" << endl;
+      return EXIT_FAILURE;
+   }
+   cout << outName << ": " << builder.size() << " words, "
+        << builder.buckets() << " buckets (largest pilot "
+        << builder.max_pilot() << "), built in " << secs * 1e3 << " ms, "
+        << table.bytes() << " bytes ("
+        << double(table.index_bytes()) / builder.size()
+        << " bytes per word besides the words)" << endl;
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,320 @@
+#include "PerfectHash.h"
+#include <cstring>   // for use of memcpy, memcmp, memset
+#include <fstream>   // for use of ofstream
+#include <algorithm> // for use of sort, stable_sort, find
+using namespace std;
+
+// average # of words per bucket (each bucket costing a 4-byte pilot)
+static const size_t BUCKET_SIZE = 4;
+
+// the share of the words (of 2^32) sent to the dense buckets, which
+// make up 30% of all the buckets
+static const uint64_t DENSE_SHARE = 2576980378ull; // 0.6 * 2^32
+
+// # of hash seeds tried before the build gives up
+static const uint64_t MAX_SEEDS = 16;
+
+// layout of the header of a perfect-hash file (see save), with every
+// field in the byte order of the machine that wrote it; the pilots,
+// the pool offsets, the tags and the pool follow in that order
+struct PerfectHashHeader
+{
+   char magic[8];           // PH_MAGIC
+   uint32_t version;        // PH_VERSION
+   uint32_t reserved;       // 0 (keeps the 64-bit fields aligned)
+   uint64_t seed;
+   uint64_t keys;
+   uint64_t buckets;
+   uint64_t dense_buckets;
+   uint64_t pilot_offset;   // file offsets of each part
+   uint64_t offset_offset;
+   uint64_t tag_offset;
+   uint64_t pool_offset;
+   uint64_t file_size;
+};
+static const char PH_MAGIC[8] = "PHDICT";
+static const uint32_t PH_VERSION = 1;
+
+// returns the bucket of the word whose hash is h: the top 32 bits
+// choose between the dense and the sparse buckets, the low 32 bits
+// the bucket among them
+static size_t bucket_of(uint64_t h, size_t buckets, size_t dense)
+{
+   uint64_t low = uint32_t(h);
+   if ((h >> 32) < DENSE_SHARE)
+      return size_t((low * dense) >> 32);
+   return dense + size_t((low * (buckets - dense)) >> 32);
+}
+
+// returns the slot (of n) the word whose hash is h goes to, given
+// the pilot of its bucket: the high 64 bits xor-ed with the low 64
+// bits of (h ^ P0) * (pilot + P1), scaled to [0, n)
+__extension__ typedef unsigned __int128 ph_uint128;
+static size_t slot_of(uint64_t h, uint32_t pilot, size_t n)
+{
+   ph_uint128 r = ph_uint128(h ^ 0xA0761D6478BD642Full)
+                  * (pilot + 0xE7037ED1A0B428DBull);
+   return size_t((ph_uint128(uint64_t(r) ^ uint64_t(r >> 64)) * n) >> 64);
+}
+
+// returns the 8-bit tag kept for the word whose hash is h
+static uint8_t tag_of(uint64_t h)
+{ return uint8_t(h >> 40); }
+
+// builds the minimal perfect hash of the words of dictionary, trying
+// a few seeds in case two of its words hash alike (or a bucket can
+// find no pilot)
+PerfectHashBuilder::PerfectHashBuilder(const HashTable& dictionary)
+   : seed(0), n_buckets(0), n_dense(0), ok(false)
+{
+   starts.push_back(0);
+   dictionary.for_each_word(add_word, this);
+   n_buckets = size() / BUCKET_SIZE + 2;
+   n_dense = n_buckets * 3 / 10 + 1;
+   for (uint64_t attempt = 1; attempt <= MAX_SEEDS && ! ok; ++attempt)
+      ok = try_seed(attempt);
+}
+
+// appends the len-character word to the builder (the context)
+void PerfectHashBuilder::add_word(const char* word, size_type len,
+                                  void* context)
+{
+   PerfectHashBuilder* builder = static_cast<PerfectHashBuilder*>(context);
+   builder->text.insert(builder->text.end(), word, word + len);
+   builder->starts.push_back(uint32_t(builder->text.size()));
+}
+
+// works out the pilots (and which word each slot holds) for the
+// hash with new_seed: the buckets are dealt with biggest first, each
+// getting the smallest pilot that sends all its words to slots still
+// free; returns false if two words hash alike or a bucket runs out
+// of pilots to try, otherwise returns true
+bool PerfectHashBuilder::try_seed(uint64_t new_seed)
+{
+   seed = new_seed;
+   size_type n = size();
+   vector<uint64_t> hashes(n);
+   for (size_type i = 0; i < n; ++i)
+      hashes[i] = hash_word64(text.data() + starts[i],
+                              starts[i + 1] - starts[i], seed);
+   vector<uint64_t> sorted(hashes);
+   sort(sorted.begin(), sorted.end());
+   for (size_type i = 1; i < n; ++i)
+      if (sorted[i] == sorted[i - 1])
+         return false;
+
+   // the words grouped by bucket: bucket b's are members[first[b]] up
+   // to members[first[b + 1]]
+   vector<uint32_t> first(n_buckets + 1, 0);
+   for (size_type i = 0; i < n; ++i)
+      first[bucket_of(hashes[i], n_buckets, n_dense) + 1]++;
+   for (size_type b = 0; b < n_buckets; ++b)
+      first[b + 1] += first[b];
+   vector<uint32_t> members(n);
+   vector<uint32_t> fill(first.begin(), first.end() - 1);
+   for (size_type i = 0; i < n; ++i)
+      members[fill[bucket_of(hashes[i], n_buckets, n_dense)]++] = uint32_t(i);
+   vector<uint32_t> order(n_buckets);
+   for (size_type b = 0; b < n_buckets; ++b)
+      order[b] = uint32_t(b);
+   stable_sort(order.begin(), order.end(), [&first](uint32_t a, uint32_t b) {
+      return first[a + 1] - first[a] > first[b + 1] - first[b];
+   });
+
+   // the last buckets placed find about one free slot in n, so allow
+   // them many more tries than that
+   uint64_t limit = 64 * uint64_t(n) + 1024;
+   if (limit > 0xFFFFFFFFull) limit = 0xFFFFFFFFull;
+   vector<bool> taken(n, false);
+   vector<size_type> slots;
+   pilots.assign(n_buckets, 0);
+   slot_words.assign(n, 0);
+   for (size_type k = 0; k < n_buckets; ++k)
+   {
+      uint32_t b = order[k];
+      if (first[b] == first[b + 1])
+         break;
+      uint32_t pilot = 0;
+      for (;; ++pilot)
+      {
+         if (pilot >= limit)
+            return false;
+         slots.clear();
+         bool fits = true;
+         for (uint32_t m = first[b]; m < first[b + 1] && fits; ++m)
+         {
+            size_type s = slot_of(hashes[members[m]], pilot, n);
+            fits = ! taken[s] && find(slots.begin(), slots.end(), s) == slots.end();
+            slots.push_back(s);
+         }
+         if (fits)
+            break;
+      }
+      for (uint32_t m = first[b]; m < first[b + 1]; ++m)
+      {
+         taken[slots[m - first[b]]] = true;
+         slot_words[slots[m - first[b]]] = members[m];
+      }
+      pilots[b] = pilot;
+   }
+   return true;
+}
+
+// returns true if every word got a slot (false only if no seed tried
+// worked)
+bool PerfectHashBuilder::built() const
+{ return ok; }
+
+// returns the # of words
+PerfectHashBuilder::size_type PerfectHashBuilder::size() const
+{ return starts.size() - 1; }
+
+// returns the # of buckets (and so of pilots)
+PerfectHashBuilder::size_type PerfectHashBuilder::buckets() const
+{ return n_buckets; }
+
+// returns the largest pilot a bucket needed
+uint32_t PerfectHashBuilder::max_pilot() const
+{
+   uint32_t most = 0;
+   for (size_type b = 0; b < pilots.size(); ++b)
+      if (pilots[b] > most) most = pilots[b];
+   return most;
+}
+
+// writes the perfect hash to filename, for a PerfectHashTable to open:
+// a header (see PerfectHashHeader), the pilots, the pool offsets of
+// the slots, their tags and then the words in slot order, back to back
+// (with no null terminators); returns true if the file was written,
+// otherwise false
+bool PerfectHashBuilder::save(const char* filename) const
+{
+   if ( ! ok )
+      return false;
+   size_type n = size();
+   PerfectHashHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, PH_MAGIC, sizeof(header.magic));
+   header.version = PH_VERSION;
+   header.seed = seed;
+   header.keys = n;
+   header.buckets = n_buckets;
+   header.dense_buckets = n_dense;
+   header.pilot_offset = sizeof(header);
+   header.offset_offset = header.pilot_offset + n_buckets * sizeof(uint32_t);
+   header.tag_offset = header.offset_offset + (n + 1) * sizeof(uint32_t);
+   header.pool_offset = header.tag_offset + n;
+   header.file_size = header.pool_offset + text.size();
+   if (text.size() > 0xFFFFFFFFull)
+      return false;
+
+   vector<uint32_t> offsets(n + 1);
+   vector<uint8_t> tags(n);
+   offsets[0] = 0;
+   for (size_type s = 0; s < n; ++s)
+   {
+      uint32_t w = slot_words[s];
+      size_type len = starts[w + 1] - starts[w];
+      offsets[s + 1] = uint32_t(offsets[s] + len);
+      tags[s] = tag_of(hash_word64(text.data() + starts[w], len, seed));
+   }
+
+   ofstream out(filename, ios::out | ios::binary | ios::trunc);
+   out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+   out.write(reinterpret_cast<const char*>(pilots.data()),
+             n_buckets * sizeof(uint32_t));
+   out.write(reinterpret_cast<const char*>(offsets.data()),
+             (n + 1) * sizeof(uint32_t));
+   out.write(reinterpret_cast<const char*>(tags.data()), n);
+   for (size_type s = 0; s < n; ++s)
+   {
+      uint32_t w = slot_words[s];
+      out.write(text.data() + starts[w], starts[w + 1] - starts[w]);
+   }
+   out.close();
+   return ! out.fail();
+}
+
+// constructs an empty dictionary (until open is called)
+PerfectHashTable::PerfectHashTable()
+   : seed(0), n_keys(0), n_buckets(0), n_dense(0), pilots(0), offsets(0),
+     tags(0), pool(0) { }
+
+// replaces the contents of the dictionary with the perfect hash in
+// filename (written by PerfectHashBuilder::save), which is mapped
+// into memory and used in place; returns false (leaving the
+// dictionary unchanged) if the file cannot be mapped or is not a
+// valid perfect-hash file, otherwise returns true
+bool PerfectHashTable::open(const char* filename)
+{
+   MappedFile mapped;
+   if ( ! mapped.open(filename) || mapped.size() < sizeof(PerfectHashHeader) )
+      return false;
+   PerfectHashHeader header;
+   memcpy(&header, mapped.data(), sizeof(header));
+   if (memcmp(header.magic, PH_MAGIC, sizeof(header.magic)) != 0 ||
+       header.version != PH_VERSION ||
+       header.file_size != mapped.size() ||
+       header.buckets < 2 || header.dense_buckets >= header.buckets ||
+       header.keys > header.file_size || header.buckets > header.file_size ||
+       header.pilot_offset != sizeof(header) ||
+       header.offset_offset != header.pilot_offset
+                               + header.buckets * sizeof(uint32_t) ||
+       header.tag_offset != header.offset_offset
+                            + (header.keys + 1) * sizeof(uint32_t) ||
+       header.pool_offset != header.tag_offset + header.keys ||
+       header.pool_offset > header.file_size)
+      return false;
+   const uint32_t* new_offsets = reinterpret_cast<const uint32_t*>(
+      mapped.data() + header.offset_offset);
+   if (new_offsets[0] != 0 ||
+       new_offsets[header.keys] != header.file_size - header.pool_offset)
+      return false;
+   // the offsets never decrease, so every word search compares lies
+   // within the pool
+   for (uint64_t i = 0; i < header.keys; ++i)
+      if (new_offsets[i + 1] < new_offsets[i])
+         return false;
+
+   file.swap(mapped); // (releasing whatever was mapped before)
+   seed = header.seed;
+   n_keys = header.keys;
+   n_buckets = header.buckets;
+   n_dense = header.dense_buckets;
+   pilots = reinterpret_cast<const uint32_t*>(file.data() + header.pilot_offset);
+   offsets = new_offsets;
+   tags = reinterpret_cast<const uint8_t*>(file.data() + header.tag_offset);
+   pool = file.data() + header.pool_offset;
+   return true;
+}
+
+// returns the # of words
+PerfectHashTable::size_type PerfectHashTable::size() const
+{ return n_keys; }
+
+// returns the # of bytes the dictionary takes up (all of it mapped)
+PerfectHashTable::size_type PerfectHashTable::bytes() const
+{ return file.size(); }
+
+// returns the # of bytes taken up by all but the words themselves
+PerfectHashTable::size_type PerfectHashTable::index_bytes() const
+{ return n_keys == 0 ? 0 : size_type(pool - file.data()); }
+
+// returns true if cStr is one of the words, otherwise returns false
+bool PerfectHashTable::search(const char* cStr) const
+{ return search(cStr, strlen(cStr)); }
+
+// returns true if the len-character word is one of the words,
+// otherwise returns false: the only slot it can be in is compared,
+// tag first
+bool PerfectHashTable::search(const char* word, size_type len) const
+{
+   if (n_keys == 0)
+      return false;
+   uint64_t h = hash_word64(word, len, seed);
+   size_type s = slot_of(h, pilots[bucket_of(h, n_buckets, n_dense)], n_keys);
+   if (tags[s] != tag_of(h))
+      return false;
+   uint32_t beg = offsets[s];
+   return offsets[s + 1] - beg == len && memcmp(pool + beg, word, len) == 0;
+}
@@ -0,0 +1,83 @@
+#ifndef PERFECT_HASH
+#define PERFECT_HASH
+
+#include <cstdlib>  // for use of size_t
+#include <cstdint>  // for use of uint32_t, uint64_t
+#include <vector>   // for use of vector
+#include "HashTable.h"
+#include "MappedFile.h"
+
+// a minimal perfect hash of a fixed set of words (PTHash-style): each
+// word's 64-bit hash (see hash_word64) picks a bucket (60% of the
+// words going to 30% of the buckets, so the big buckets are few), and
+// each bucket has a pilot value, found at build time, that sends its
+// words to slots no other word takes; the n words fill slots 0 .. n - 1
+// exactly, so a lookup hashes the word, reads its bucket's pilot and
+// then looks at the one slot the word can be in, which holds the
+// word's 8-bit tag and where its characters start in a packed string
+// pool
+// a PerfectHashBuilder works out the pilots and writes them, with the
+// slots and the pool, to a file a PerfectHashTable maps in as is
+
+// builds (once) the minimal perfect hash of the words of a dictionary
+class PerfectHashBuilder
+{
+public:
+   typedef size_t size_type;
+   explicit PerfectHashBuilder(const HashTable& dictionary);
+   bool built() const;
+   size_type size() const;
+   size_type buckets() const;
+   uint32_t max_pilot() const;
+   bool save(const char* filename) const;
+private:
+   std::vector<char> text;        // the words, back to back
+   std::vector<uint32_t> starts;  // word i is text[starts[i]] up to
+                                  // text[starts[i + 1]]
+   uint64_t seed;                 // of the hash the pilots work with
+   size_type n_buckets;
+   size_type n_dense;             // # of buckets the 60% go to
+   std::vector<uint32_t> pilots;  // one per bucket
+   std::vector<uint32_t> slot_words; // the word in each slot
+   bool ok;
+
+   static void add_word(const char* word, size_type len, void* context);
+   bool try_seed(uint64_t new_seed);
+
+   // disable copy construction & copy assignment
+   PerfectHashBuilder(const PerfectHashBuilder& src);
+   void operator=(const PerfectHashBuilder& rhs);
+};
+
+// a read-only dictionary: the minimal perfect hash a
+// PerfectHashBuilder saved, mapped into memory and used in place
+class PerfectHashTable
+{
+public:
+   typedef size_t size_type;
+   PerfectHashTable();
+   bool open(const char* filename);
+   size_type size() const;
+   size_type bytes() const;
+   size_type index_bytes() const;
+   bool search(const char* cStr) const;
+   bool search(const char* word, size_type len) const;
+private:
+   MappedFile file;
+   uint64_t seed;
+   size_type n_keys;
+   size_type n_buckets;
+   size_type n_dense;
+   const uint32_t* pilots;   // n_buckets pilots
+   const uint32_t* offsets;  // n_keys + 1 pool offsets (slot i's word
+                             // is pool[offsets[i]] up to
+                             // pool[offsets[i + 1]])
+   const uint8_t* tags;      // n_keys tags
+   const char* pool;
+
+   // disable copy construction & copy assignment
+   PerfectHashTable(const PerfectHashTable& src);
+   void operator=(const PerfectHashTable& rhs);
+};
+
+#endif
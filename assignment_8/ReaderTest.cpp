@@ -0,0 +1,88 @@
+// FILE: ReaderTest.cpp
+// Checks that searches of a ConcurrentHashTable from several threads
+// at once, while another thread inserts and erases words, are free of
+// data races and always find the dictionary's words; built (as
+// readertest) with -fsanitize=thread, which reports any race the run
+// takes, and run as
+//    readertest [dictionary]
+// (dict1.txt if not given); exits with EXIT_FAILURE if a search
+// missed a word that was in the table throughout
+#include "ConcurrentHashTable.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+using namespace std;
+
+// # of reader threads, and of passes each makes over the words
+const int READERS = 4;
+const int PASSES = 20;
+
+int main(int argc, char* argv[])
+{
+   const char* dictName = argc > 1 ? argv[1] : "dict1.txt";
+   ifstream in(dictName);
+   vector<string> words;
+   string word;
+   while (in >> word)
+      words.push_back(word);
+   if (words.empty())
+   {
+      cerr << "Failed to read dictionary file " << dictName << endl;
+      return EXIT_FAILURE;
+   }
+   vector<const char*> cWords;
+   for (size_t i = 0; i < words.size(); ++i)
+      cWords.push_back(words[i].c_str());
+
+   ConcurrentHashTable cTab;
+   cTab.insert_range(&cWords[0], cWords.size());
+
+   atomic<int> reading(READERS);
+   atomic<long> misses(0);
+   vector<thread> pool;
+   for (int t = 0; t < READERS; ++t)
+      pool.push_back(thread([&, t]() {
+         bool found[64];
+         for (int pass = 0; pass < PASSES; ++pass)
+            for (size_t i = t; i < cWords.size(); i += 64)
+            {
+               // alternate single searches and batches
+               size_t n = cWords.size() - i < 64 ? cWords.size() - i : 64;
+               if (pass % 2 == 0)
+                  for (size_t k = 0; k < n; ++k)
+                     found[k] = cTab.search(cWords[i + k]);
+               else
+                  cTab.search_batch(&cWords[i], n, found);
+               for (size_t k = 0; k < n; ++k)
+                  if ( ! found[k] )
+                     misses++;
+            }
+         reading--;
+      }));
+
+   // meanwhile, the writer adds and erases words of its own, making
+   // each replica rehash as it grows
+   char newWord[32];
+   long writes = 0;
+   while (reading.load() > 0)
+   {
+      sprintf(newWord, "zz%ld", writes++);
+      cTab.insert_if_absent(newWord);
+      if (writes % 3 == 0)
+      {
+         sprintf(newWord, "zz%ld", writes / 2);
+         cTab.erase(newWord);
+      }
+   }
+   for (size_t t = 0; t < pool.size(); ++t)
+      pool[t].join();
+
+   cout << dictName << ": " << READERS << " readers, " << writes
+        << " inserts, " << misses.load() << " words missed" << endl;
+   return misses.load() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,247 @@
+#include "SpellSuggester.h"
+#include "Dawg.h"
+#include <cstring>
+#include <algorithm> // for use of sort, unique, push_heap, pop_heap
+using namespace std;
+
+// the djb2 hash value of the empty word, and its multiplier
+static const uint32_t DJB2_SEED = 5381;
+static const uint32_t DJB2_FACTOR = 33;
+
+// constructs a suggester for the words of dictionary, generating the
+// kinds of edit in edit_kinds (see edit_kind)
+SpellSuggester::SpellSuggester(const HashTable& dictionary,
+                               unsigned edit_kinds)
+   : dict(dictionary), graph(0), edits(edit_kinds)
+{
+   powers[0] = 1;
+   for (size_type k = 1; k < MAX_LENGTH + 2; ++k)
+      powers[k] = powers[k - 1] * DJB2_FACTOR;
+}
+
+// constructs a suggester for the words of dictionary that walks
+// words, an automaton of the same words (built with their counts, if
+// the dictionary has any), rather than generating candidates
+SpellSuggester::SpellSuggester(const HashTable& dictionary, const Dawg& words)
+   : dict(dictionary), graph(&words), edits(ALL_EDITS)
+{
+   powers[0] = 1;
+   for (size_type k = 1; k < MAX_LENGTH + 2; ++k)
+      powers[k] = powers[k - 1] * DJB2_FACTOR;
+}
+
+// out is set to the words of the dictionary (other than word itself)
+// that up to max_distance edits make word into, sorted and without
+// repeats; returns the # of candidates looked up
+SpellSuggester::size_type
+SpellSuggester::suggest(const char* word, vector<string>& out,
+                        unsigned max_distance) const
+{
+   vector<Hit> hits;
+   size_type tried = find_hits(word, max_distance, hits);
+   out.clear();
+   for (size_type h = 0; h < hits.size(); ++h)
+      out.push_back(hits[h].word);
+   return tried;
+}
+
+// out is set to the (up to) k words suggest would find with the
+// highest counts, highest first (words with the same count in
+// alphabetical order); they are picked with a heap of the best k
+// found so far, whose root is the worst of them; returns the # of
+// candidates looked up
+SpellSuggester::size_type
+SpellSuggester::suggest_top(const char* word, vector<string>& out,
+                            size_type k, unsigned max_distance) const
+{
+   vector<Hit> hits;
+   size_type tried = find_hits(word, max_distance, hits);
+   vector<Hit> best;
+   for (size_type h = 0; h < hits.size() && k > 0; ++h)
+   {
+      if (best.size() < k)
+      {
+         best.push_back(hits[h]);
+         push_heap(best.begin(), best.end(), ranks_higher);
+      }
+      else if (ranks_higher(hits[h], best.front()))
+      {
+         pop_heap(best.begin(), best.end(), ranks_higher);
+         best.back() = hits[h];
+         push_heap(best.begin(), best.end(), ranks_higher);
+      }
+   }
+   sort_heap(best.begin(), best.end(), ranks_higher);
+   out.clear();
+   for (size_type b = 0; b < best.size(); ++b)
+      out.push_back(best[b].word);
+   return tried;
+}
+
+// hits is set to the dictionary words (other than word itself) that
+// up to max_distance edits make word into, with their counts, sorted
+// by word and without repeats; returns the # of candidates looked up
+SpellSuggester::size_type
+SpellSuggester::find_hits(const char* word, unsigned max_distance,
+                          vector<Hit>& hits) const
+{
+   hits.clear();
+   size_type len = strlen(word);
+   size_type tried = 0;
+   if (len > MAX_LENGTH || max_distance == 0)
+      return 0;
+   if (graph != 0)
+   {
+      // the words come sorted and without repeats, with their counts
+      // (read off the automaton, not looked up)
+      vector<string> near;
+      vector<uint32_t> counts;
+      tried = graph->near(word, max_distance, near, &counts);
+      for (size_type n = 0; n < near.size(); ++n)
+         if (near[n] != word)
+         {
+            Hit hit;
+            hit.word = near[n];
+            hit.count = counts[n];
+            hits.push_back(hit);
+         }
+      return tried;
+   }
+   expand(word, len, max_distance, word, len, hits, tried);
+   sort(hits.begin(), hits.end(), by_word);
+   hits.erase(unique(hits.begin(), hits.end(), same_word), hits.end());
+   return tried;
+}
+
+// returns true if a's word comes before b's alphabetically
+bool SpellSuggester::by_word(const Hit& a, const Hit& b)
+{ return a.word < b.word; }
+
+// returns true if a and b are the same word
+bool SpellSuggester::same_word(const Hit& a, const Hit& b)
+{ return a.word == b.word; }
+
+// returns true if a is a better suggestion than b: it has a higher
+// count, or the same count and comes first alphabetically
+bool SpellSuggester::ranks_higher(const Hit& a, const Hit& b)
+{ return a.count != b.count ? a.count > b.count : a.word < b.word; }
+
+// every candidate one edit away from the len-character word is
+// visited (see visit), with distance edits still allowed in all
+// prefix[k] is the djb2 hash value of the first k characters, and
+// suffix[k] the sum over the characters from the k-th on of each
+// character times 33 to the power of the # of characters after it,
+// so that the hash value of the word is
+//    prefix[k] * 33^(len - k) + suffix[k]
+// for any k, and that of an edit at position x is put together from
+// prefix[x], the edited characters and the suffix sum after them
+void SpellSuggester::expand(const char* word, size_type len,
+                            unsigned distance, const char* original,
+                            size_type original_len, vector<Hit>& out,
+                            size_type& tried) const
+{
+   const unsigned char* w = reinterpret_cast<const unsigned char*>(word);
+   uint32_t prefix[MAX_LENGTH + 1], suffix[MAX_LENGTH + 1];
+   char buffer[MAX_LENGTH + 1];
+   prefix[0] = DJB2_SEED;
+   for (size_type k = 0; k < len; ++k)
+      prefix[k + 1] = prefix[k] * DJB2_FACTOR + w[k];
+   suffix[len] = 0;
+   for (size_type k = len; k > 0; --k)
+      suffix[k - 1] = suffix[k] + w[k - 1] * powers[len - k];
+
+   if ((edits & DELETION) && len > 0)
+   {
+      // buffer holds word less its x-th character
+      memcpy(buffer, word + 1, len - 1);
+      for (size_type x = 0; x < len; ++x)
+      {
+         if (x > 0)
+            buffer[x - 1] = word[x - 1];
+         if (x > 0 && word[x] == word[x - 1])
+            continue; // same as deleting the one before
+         visit(buffer, len - 1, prefix[x] * powers[len - 1 - x] + suffix[x + 1],
+               distance, original, original_len, out, tried);
+      }
+   }
+
+   if ((edits & TRANSPOSITION) && len > 1)
+   {
+      memcpy(buffer, word, len);
+      for (size_type x = 0; x + 1 < len; ++x)
+      {
+         if (word[x] == word[x + 1])
+            continue;
+         buffer[x] = word[x + 1];
+         buffer[x + 1] = word[x];
+         visit(buffer, len, prefix[x] * powers[len - x]
+                            + w[x + 1] * powers[len - 1 - x]
+                            + w[x] * powers[len - 2 - x] + suffix[x + 2],
+               distance, original, original_len, out, tried);
+         buffer[x] = word[x];
+         buffer[x + 1] = word[x + 1];
+      }
+   }
+
+   if (edits & SUBSTITUTION)
+   {
+      memcpy(buffer, word, len);
+      for (size_type x = 0; x < len; ++x)
+      {
+         uint32_t head = prefix[x] * powers[len - x];
+         for (unsigned char c = 'a'; c <= 'z'; ++c)
+         {
+            if (c == w[x]) continue;
+            buffer[x] = char(c);
+            visit(buffer, len, head + c * powers[len - 1 - x] + suffix[x + 1],
+                  distance, original, original_len, out, tried);
+         }
+         buffer[x] = word[x];
+      }
+   }
+
+   if ((edits & INSERTION) && len < MAX_LENGTH)
+   {
+      // buffer holds word with a gap (at x) for the inserted character
+      memcpy(buffer + 1, word, len);
+      for (size_type x = 0; x <= len; ++x)
+      {
+         if (x > 0)
+            buffer[x - 1] = word[x - 1];
+         uint32_t head = prefix[x] * powers[len + 1 - x];
+         for (unsigned char c = 'a'; c <= 'z'; ++c)
+         {
+            if (x > 0 && c == w[x - 1])
+               continue; // same as inserting c one place earlier
+            buffer[x] = char(c);
+            visit(buffer, len + 1, head + c * powers[len - x] + suffix[x],
+                  distance, original, original_len, out, tried);
+         }
+      }
+   }
+}
+
+// the len-character candidate, whose djb2 hash value is fingerprint,
+// is looked up and, if in the dictionary (and not the original word),
+// added to out with its count (which the lookup gives); with distance
+// edits still allowed, the candidates one edit away from it are then
+// visited in turn
+void SpellSuggester::visit(const char* candidate, size_type len,
+                           uint32_t fingerprint, unsigned distance,
+                           const char* original, size_type original_len,
+                           vector<Hit>& out, size_type& tried) const
+{
+   if (dict.hasher() != HashTable::DJB2_HASH)
+      fingerprint = hash_word(dict.hasher(), candidate, len);
+   ++tried;
+   Hit hit;
+   hit.count = 0;
+   if (dict.search_hashed(candidate, len, fingerprint, &hit.count) &&
+       ! (len == original_len && memcmp(candidate, original, len) == 0))
+   {
+      hit.word.assign(candidate, len);
+      out.push_back(hit);
+   }
+   if (distance > 1)
+      expand(candidate, len, distance - 1, original, original_len, out, tried);
+}
@@ -0,0 +1,71 @@
+#ifndef SPELL_SUGGESTER
+#define SPELL_SUGGESTER
+
+#include <string>   // for use of string
+#include <vector>   // for use of vector
+#include "HashTable.h"
+
+class Dawg;
+
+// finds the words of a dictionary (a HashTable) that are within a
+// small edit distance of a given word, by generating every word one
+// edit away (and, for distance 2, one edit away from those) and
+// looking each up
+// a candidate is never hashed from scratch: with djb2, the hash value
+// of a word is a polynomial in 33 of its characters, so that of an
+// edit of the word follows in O(1) from the hash values of the
+// word's prefixes and the sums of its suffixes; nor is a candidate
+// copied out in full, but made by changing a byte or two of a buffer
+// (with the other hash functions, each candidate is hashed in full)
+// the words found can be ranked by their counts in the dictionary
+// (see HashTable::count), which come with each lookup, and only the
+// top k kept (see suggest_top)
+// given a Dawg of the dictionary's words, nothing is generated: the
+// words near a word are found by walking the automaton instead (see
+// Dawg::near), with every kind of edit allowed, the counts coming
+// from the automaton, and the # of candidates reported is the # of
+// rows of edit distances worked out (generating is the quicker at
+// distance 1, walking by far at distance 2)
+class SpellSuggester
+{
+public:
+   typedef HashTable::size_type size_type;
+   // the kinds of edit generated (or-ed together)
+   enum edit_kind { SUBSTITUTION = 1, INSERTION = 2, DELETION = 4,
+                    TRANSPOSITION = 8, ALL_EDITS = 15 };
+   // longest word (or candidate) handled
+   static const size_type MAX_LENGTH = 100;
+   explicit SpellSuggester(const HashTable& dictionary,
+                           unsigned edit_kinds = ALL_EDITS);
+   SpellSuggester(const HashTable& dictionary, const Dawg& words);
+   size_type suggest(const char* word, std::vector<std::string>& out,
+                     unsigned max_distance = 1) const;
+   size_type suggest_top(const char* word, std::vector<std::string>& out,
+                         size_type k, unsigned max_distance = 1) const;
+private:
+   // a dictionary word found, with its count
+   struct Hit
+   {
+      std::string word;
+      uint32_t count;
+   };
+   const HashTable& dict;
+   const Dawg* graph;   // the automaton walked, if any (otherwise 0)
+   unsigned edits;
+   uint32_t powers[MAX_LENGTH + 2];   // powers[k] is 33^k (mod 2^32)
+
+   void expand(const char* word, size_type len, unsigned distance,
+               const char* original, size_type original_len,
+               std::vector<Hit>& out, size_type& tried) const;
+   void visit(const char* candidate, size_type len, uint32_t fingerprint,
+              unsigned distance, const char* original,
+              size_type original_len, std::vector<Hit>& out,
+              size_type& tried) const;
+   size_type find_hits(const char* word, unsigned max_distance,
+                       std::vector<Hit>& hits) const;
+   static bool by_word(const Hit& a, const Hit& b);
+   static bool same_word(const Hit& a, const Hit& b);
+   static bool ranks_higher(const Hit& a, const Hit& b);
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "TextKernels.h"
+#include <cstdint>  // for use of uint32_t, uint64_t
+#include <cstring>  // for use of memcpy
+#include <atomic>   // for use of atomic
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEXT_KERNELS_X86
+#endif
+using namespace std;
+
+// the routines of one level (see use_kernels)
+struct Kernels
+{
+   kernel_level level;
+   void (*lower)(const char* src, char* dst, size_t n);
+   size_t (*words)(const char* text, size_t n, vector<WordSpan>& out);
+   size_t (*tokens)(const char* text, size_t n, vector<WordSpan>& out);
+};
+
+// the routines in use (0 until one is first called)
+static atomic<const Kernels*> active(0);
+
+// --- byte classes, one byte at a time ---
+
+// returns true if c is an ASCII capital letter
+static bool is_capital(char c)
+{ return c >= 'A' && c <= 'Z'; }
+
+// returns true if c belongs to a word (a lowercase letter)
+static bool is_letter(char c)
+{ return c >= 'a' && c <= 'z'; }
+
+// returns true if c belongs to a dictionary word (is not whitespace)
+static bool is_token(char c)
+{ return ! (c == ' ' || (c >= '\t' && c <= '\r') || c == '\0'); }
+
+// appends to out the runs of the n bytes at text whose bytes are all
+// in the class whose block mask function is mask (bit k of
+// mask(p) set if p[k] is in the class, for a block of width bytes)
+// and whose byte test is in_class; returns the # of runs appended
+// only the blocks where a run starts or ends are looked at bit by
+// bit (see emit)
+template <size_t width, uint32_t (*mask)(const char*), bool (*in_class)(char)>
+static size_t find_runs(const char* text, size_t n, vector<WordSpan>& out)
+{
+   const uint32_t full = (width == 32) ? 0xFFFFFFFFu : (uint32_t(1) << width) - 1;
+   size_t found = 0;
+   bool in_run = false;
+   WordSpan run;
+   run.start = 0;
+   size_t i = 0;
+   for (; i + width <= n; i += width)
+   {
+      uint32_t m = mask(text + i);
+      if (m == (in_run ? full : 0))
+         continue;
+      // a set bit of edges marks a byte that starts or ends a run
+      uint32_t edges = (m ^ ((m << 1) | (in_run ? 1 : 0))) & full;
+      while (edges != 0)
+      {
+         size_t k = size_t(__builtin_ctz(edges));
+         edges &= edges - 1;
+         if (in_run)
+         {
+            run.length = i + k - run.start;
+            out.push_back(run);
+            ++found;
+         }
+         else
+            run.start = i + k;
+         in_run = ! in_run;
+      }
+   }
+   for (; i < n; ++i)
+   {
+      if (in_class(text[i]) == in_run)
+         continue;
+      if (in_run)
+      {
+         run.length = i - run.start;
+         out.push_back(run);
+         ++found;
+      }
+      else
+         run.start = i;
+      in_run = ! in_run;
+   }
+   if (in_run)
+   {
+      run.length = n - run.start;
+      out.push_back(run);
+      ++found;
+   }
+   return found;
+}
+
+// --- 8 bytes at a time, in a 64-bit integer ---
+
+// a byte value repeated in all 8 bytes of a 64-bit integer
+static const uint64_t ONES = 0x0101010101010101ull;
+static const uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+// returns the 8 bytes at p (in machine order)
+static uint64_t load8(const char* p)
+{ uint64_t v; memcpy(&v, p, 8); return v; }
+
+// returns the high bit of each byte of v that is in [lo, hi] set,
+// all other bits clear
+static uint64_t in_range(uint64_t v, unsigned char lo, unsigned char hi)
+{
+   uint64_t low7 = v & ~HIGH_BITS;
+   uint64_t at_least_lo = low7 + ONES * (0x80 - lo);
+   uint64_t above_hi = low7 + ONES * (0x7F - hi);
+   return at_least_lo & ~above_hi & ~v & HIGH_BITS;
+}
+
+// returns the high bits of the bytes of v gathered into 8 bits
+// (bit k from byte k, in little-endian order)
+static uint32_t gather_high_bits(uint64_t v)
+{ return uint32_t((((v & HIGH_BITS) >> 7) * 0x0102040810204080ull) >> 56); }
+
+static uint32_t letters_swar(const char* p)
+{ return gather_high_bits(in_range(load8(p), 'a', 'z')); }
+
+static uint32_t tokens_swar(const char* p)
+{
+   uint64_t v = load8(p);
+   uint64_t space = in_range(v, ' ', ' ') | in_range(v, '\t', '\r')
+                    | in_range(v, 0, 0);
+   return gather_high_bits(~space & HIGH_BITS);
+}
+
+static void lower_swar(const char* src, char* dst, size_t n)
+{
+   size_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      uint64_t v = load8(src + i);
+      v |= in_range(v, 'A', 'Z') >> 2; // 0x80 >> 2 is the case bit
+      memcpy(dst + i, &v, 8);
+   }
+   for (; i < n; ++i)
+      dst[i] = is_capital(src[i]) ? char(src[i] | 0x20) : src[i];
+}
+
+static size_t words_swar(const char* text, size_t n, vector<WordSpan>& out)
+{ return find_runs<8, letters_swar, is_letter>(text, n, out); }
+
+static size_t tokens_swar_runs(const char* text, size_t n, vector<WordSpan>& out)
+{ return find_runs<8, tokens_swar, is_token>(text, n, out); }
+
+#ifdef TEXT_KERNELS_X86
+// --- 16 bytes at a time (SSE2) ---
+// the range tests compare signed bytes, so bytes from 0x80 on (which
+// are negative) are never in a range of ASCII characters
+
+__attribute__((target("sse2")))
+static uint32_t letters_sse2(const char* p)
+{
+   __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+   __m128i in = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)),
+                              _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+   return uint32_t(_mm_movemask_epi8(in));
+}
+
+__attribute__((target("sse2")))
+static uint32_t tokens_sse2(const char* p)
+{
+   __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+   __m128i space = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                   _mm_cmpeq_epi8(v, _mm_setzero_si128())),
+      _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+                    _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1))));
+   return uint32_t(_mm_movemask_epi8(space)) ^ 0xFFFFu;
+}
+
+__attribute__((target("sse2")))
+static void lower_sse2(const char* src, char* dst, size_t n)
+{
+   size_t i = 0;
+   for (; i + 16 <= n; i += 16)
+   {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      __m128i capital = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+      v = _mm_or_si128(v, _mm_and_si128(capital, _mm_set1_epi8(0x20)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+   }
+   lower_swar(src + i, dst + i, n - i);
+}
+
+static size_t words_sse2(const char* text, size_t n, vector<WordSpan>& out)
+{ return find_runs<16, letters_sse2, is_letter>(text, n, out); }
+
+static size_t tokens_sse2_runs(const char* text, size_t n, vector<WordSpan>& out)
+{ return find_runs<16, tokens_sse2, is_token>(text, n, out); }
+
+// --- 32 bytes at a time (AVX2) ---
+
+__attribute__((target("avx2")))
+static uint32_t letters_avx2(const char* p)
+{
+   __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+   __m256i in = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a' - 1)),
+                                 _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), v));
+   return uint32_t(_mm256_movemask_epi8(in));
+}
+
+__attribute__((target("avx2")))
+static uint32_t tokens_avx2(const char* p)
+{
+   __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+   __m256i space = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                      _mm256_cmpeq_epi8(v, _mm256_setzero_si256())),
+      _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)),
+                       _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v)));
+   return ~uint32_t(_mm256_movemask_epi8(space));
+}
+
+__attribute__((target("avx2")))
+static void lower_avx2(const char* src, char* dst, size_t n)
+{
+   size_t i = 0;
+   for (; i + 32 <= n; i += 32)
+   {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+      __m256i capital = _mm256_and_si256(
+         _mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+         _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+      v = _mm256_or_si256(v, _mm256_and_si256(capital, _mm256_set1_epi8(0x20)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+   }
+   lower_sse2(src + i, dst + i, n - i);
+}
+
+static size_t words_avx2(const char* text, size_t n, vector<WordSpan>& out)
+{ return find_runs<32, letters_avx2, is_letter>(text, n, out); }
+
+static size_t tokens_avx2_runs(const char* text, size_t n, vector<WordSpan>& out)
+{ return find_runs<32, tokens_avx2, is_token>(text, n, out); }
+#endif
+
+// --- choosing a level ---
+
+static Kernels all_kernels[] =
+{
+   { SCALAR_KERNELS, lower_swar, words_swar, tokens_swar_runs },
+#ifdef TEXT_KERNELS_X86
+   { SSE2_KERNELS, lower_sse2, words_sse2, tokens_sse2_runs },
+   { AVX2_KERNELS, lower_avx2, words_avx2, tokens_avx2_runs },
+#endif
+};
+
+kernel_level best_kernels()
+{
+#ifdef TEXT_KERNELS_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return AVX2_KERNELS;
+   if (__builtin_cpu_supports("sse2"))
+      return SSE2_KERNELS;
+#endif
+   return SCALAR_KERNELS;
+}
+
+kernel_level use_kernels(kernel_level level)
+{
+   kernel_level best = best_kernels();
+   if (level > best)
+      level = best;
+   active.store(&all_kernels[level]);
+   return level;
+}
+
+const char* kernel_name(kernel_level level)
+{
+   switch (level)
+   {
+   case AVX2_KERNELS: return "avx2";
+   case SSE2_KERNELS: return "sse2";
+   default:           return "scalar";
+   }
+}
+
+// returns the routines in use, picking the best the first time
+static const Kernels& current_kernels()
+{
+   const Kernels* kernels = active.load();
+   if (kernels == 0)
+   {
+      use_kernels(best_kernels());
+      kernels = active.load();
+   }
+   return *kernels;
+}
+
+void lower_ascii(const char* src, char* dst, size_t n)
+{ current_kernels().lower(src, dst, n); }
+
+size_t find_words(const char* text, size_t n, vector<WordSpan>& words)
+{ return current_kernels().words(text, n, words); }
+
+size_t find_tokens(const char* text, size_t n, vector<WordSpan>& words)
+{ return current_kernels().tokens(text, n, words); }
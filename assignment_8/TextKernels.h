@@ -0,0 +1,48 @@
+#ifndef TEXT_KERNELS
+#define TEXT_KERNELS
+
+#include <cstdlib>  // for use of size_t
+#include <vector>   // for use of vector
+
+// bulk text routines for spell-checking whole documents and parsing
+// dictionaries; each comes in versions working on 32 bytes at a time
+// (AVX2), 16 (SSE2) and 8 (packed in a 64-bit integer), the widest
+// the processor supports being picked the first time one is called
+// (a text is only looked at a byte at a time where a word starts or
+// ends)
+
+// where a word lies in a text: its first byte and # of bytes
+struct WordSpan
+{
+   size_t start;
+   size_t length;
+};
+
+// the versions of the routines (see use_kernels)
+enum kernel_level { SCALAR_KERNELS, SSE2_KERNELS, AVX2_KERNELS };
+
+// dst is set to the n bytes at src with the ASCII capital letters
+// made lowercase (dst may be src)
+void lower_ascii(const char* src, char* dst, size_t n);
+
+// appends to words the words (maximal runs of the lowercase letters
+// a - z) in the n bytes at text; returns the # of words appended
+size_t find_words(const char* text, size_t n, std::vector<WordSpan>& words);
+
+// appends to words the whitespace-separated words (maximal runs of
+// bytes other than space, \t, \n, \v, \f, \r and \0) in the n bytes
+// at text, as in a dictionary file; returns the # of words appended
+size_t find_tokens(const char* text, size_t n, std::vector<WordSpan>& words);
+
+// returns the widest version of the routines the processor supports
+kernel_level best_kernels();
+
+// makes the routines use their level version from now on (or the
+// best the processor supports, if level is beyond it); returns the
+// level actually used
+kernel_level use_kernels(kernel_level level);
+
+// returns the name ("scalar", "sse2" or "avx2") of a level
+const char* kernel_name(kernel_level level);
+
+#endif